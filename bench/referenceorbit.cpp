@@ -0,0 +1,54 @@
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+// Time of a reference orbit against the precision of its center, with the plain double orbit as the baseline.
+// The center is inside the set, so every orbit runs the full iteration count.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include "../perturbation.h"
+
+template <typename Compute>
+static double nanosecondsPerIteration(int iterations, Compute compute)
+{
+    auto begin = std::chrono::steady_clock::now();
+    compute();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - begin;
+    return elapsed.count() / iterations;
+}
+
+int main()
+{
+    const double re = -0.25;
+    const double im = 0.25;
+
+    const int baselineIterations = 1000000;
+    std::vector<double> zRe, zIm;
+    double baseline = nanosecondsPerIteration(baselineIterations, [&]() { computeOrbit(re, im, baselineIterations, zRe, zIm); });
+    printf("%10s %8s %14s %10s\n", "bits", "limbs", "ns/iteration", "vs double");
+    printf("%10s %8s %14.1f %10.1f\n", "double", "-", baseline, 1.0);
+
+    for (int limbs = FixedPoint::defaultFractionLimbs; limbs <= 512; limbs *= 2) {
+        // keep every row at a similar total amount of work
+        const int iterations = std::max(1000, 20000000 / (limbs * limbs));
+        ReferenceOrbit orbit;
+        double time = nanosecondsPerIteration(iterations, [&]() { orbit.compute(FixedPoint(re, limbs), FixedPoint(im, limbs), iterations); });
+        printf("%10d %8d %14.1f %10.1f\n", limbs * FixedPoint::limbBits, limbs, time, time / baseline);
+    }
+}
@@ -0,0 +1,72 @@
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "bla.h"
+#include <algorithm>
+
+static BlaStep merge(const BlaStep &x, const BlaStep &y, double dcRadius)
+{
+    double radius = std::min(x.radius, std::max(0.0, (y.radius - std::abs(x.b) * dcRadius) / std::abs(x.a)));
+    return { y.a * x.a, y.a * x.b + y.b, radius, radius * radius };
+}
+
+static BlaStep single(const ReferenceOrbit &orbit, size_t m)
+{
+    std::complex<double> z(orbit.zRe[m], orbit.zIm[m]);
+    double radius = BlaTable::epsilon * std::abs(z);
+    return { 2.0 * z, 1.0, radius, radius * radius };
+}
+
+void BlaTable::build(const ReferenceOrbit &orbit, double dcRadius, ThreadPool &pool)
+{
+    clear();
+    mOrbit = &orbit;
+    mOrbitSize = orbit.zRe.size();
+    mDcRadius = dcRadius;
+
+    // steps cover iterations [1, last], Z_0 = 0 has no linear part; every level is built in parallel from the one below
+    const size_t span = mOrbitSize >= 2 ? mOrbitSize - 2 : 0;
+    const size_t chunk = 4096;
+    for (size_t length = 2; length <= span; length *= 2) {
+        auto &level = mLevels.emplace_back(span / length);
+        const auto *below = mLevels.size() > 1 ? &mLevels[mLevels.size() - 2] : nullptr;
+        pool.run((level.size() + chunk - 1) / chunk, [&](size_t c, unsigned) {
+            for (size_t j = c * chunk; j < std::min(level.size(), (c + 1) * chunk); ++j) {
+                if (below) {
+                    level[j] = merge((*below)[2 * j], (*below)[2 * j + 1], dcRadius);
+                } else {
+                    level[j] = merge(single(orbit, 1 + 2 * j), single(orbit, 2 + 2 * j), dcRadius);
+                }
+            }
+        });
+    }
+    // merged steps are never larger than the first level
+    if (!mLevels.empty()) {
+        for (const auto &step : mLevels.front()) {
+            mMaxRadius2 = std::max(mMaxRadius2, step.radius2);
+        }
+    }
+}
+
+void BlaTable::clear()
+{
+    mLevels.clear();
+    mOrbit = nullptr;
+    mOrbitSize = 0;
+    mDcRadius = 0.0;
+    mMaxRadius2 = 0.0;
+}
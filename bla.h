@@ -0,0 +1,83 @@
+#pragma once
+
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Bilinear approximation of the perturbation iteration. While |dz| is small next to |Z|, the dz^2 term vanishes and
+// one step is linear in dz and dc: dz' = A * dz + B * dc (A = 2 * Z, B = 1). Two consecutive steps compose into one:
+//   A = A_y * A_x,  B = A_y * B_x + B_y,  radius = min(r_x, (r_y - |B_x| * |dc|) / |A_x|)
+// so a table of merged steps of length 2, 4, 8, ... lets a pixel jump many iterations at once wherever it is on the
+// orbit, as long as its |dz| is within the radius of the step.
+
+#include <algorithm>
+#include <complex>
+#include <vector>
+#include "perturbation.h"
+#include "threadpool.h"
+
+struct BlaStep {
+    std::complex<double> a;
+    std::complex<double> b;
+    double radius;
+    double radius2;
+};
+
+class BlaTable
+{
+public:
+    // relative size of the dropped dz^2 term against 2 * Z * dz still considered exact
+    static constexpr double epsilon = 0x1p-40;
+
+    // dcRadius is the largest |dc| that will be looked up, the table stays valid for any smaller one
+    void build(const ReferenceOrbit &orbit, double dcRadius, ThreadPool &pool);
+    void clear();
+    bool isValidFor(const ReferenceOrbit &orbit, double dcRadius) const { return mOrbit == &orbit && mOrbitSize == orbit.zRe.size() && dcRadius <= mDcRadius; }
+
+    // Longest step starting at iteration m (>= 1) that is valid for |dz|^2 = dzNorm and ends at or before iteration
+    // limit, nullptr if there is none. length receives its number of iterations.
+    // Called for every perturbation iteration, hence inline with the common rejections first: only levels whose step
+    // grid contains m qualify (the trailing zero bits of m - 1), and since a merged step is never valid further than
+    // its first half the search goes up from the shortest step and stops at the first one that doesn't fit.
+    const BlaStep *lookup(int m, double dzNorm, int limit, int &length) const
+    {
+        unsigned offset = static_cast<unsigned>(m - 1);
+        if (m < 1 || (offset & 1) || !(dzNorm < mMaxRadius2)) {
+            return nullptr;
+        }
+        int levels = offset ? std::min<int>(__builtin_ctz(offset), static_cast<int>(mLevels.size())) : static_cast<int>(mLevels.size());
+        const BlaStep *best = nullptr;
+        for (int k = 0; k < levels; ++k) {
+            size_t j = offset >> (k + 1);
+            int stepLength = 2 << k;
+            if (j >= mLevels[k].size() || m + stepLength > limit || !(dzNorm < mLevels[k][j].radius2)) {
+                break;
+            }
+            best = &mLevels[k][j];
+            length = stepLength;
+        }
+        return best;
+    }
+
+private:
+    // mLevels[k] holds steps of 2^(k + 1) iterations, entry j starts at iteration 1 + j * 2^(k + 1)
+    std::vector<std::vector<BlaStep>> mLevels;
+    const ReferenceOrbit *mOrbit = nullptr;
+    size_t mOrbitSize = 0;
+    double mDcRadius = 0.0;
+    // largest radius^2 of any step, pixels that drifted further from the reference skip the table at once
+    double mMaxRadius2 = 0.0;
+};
@@ -0,0 +1,58 @@
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+#include "cmdline.h"
+#include <cstdlib>
+#include <string>
+
+bool parseCpuOption(int argc, char *argv[], int &i, CpuRenderer::Options &options)
+{
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if (arg == "--no-subdivide") {
+        options.subdivide = false;
+    } else if (arg == "--no-symmetry") {
+        options.symmetry = false;
+    } else if (arg == "--snap-axis") {
+        options.snapAxis = true;
+    } else if (arg == "--no-cardioid") {
+        options.cardioid = false;
+    } else if (arg == "--no-periodicity") {
+        options.periodicity = false;
+    } else if (arg == "--derivative") {
+        options.derivative = true;
+    } else if (arg == "--no-progressive") {
+        options.passStep = 1;
+    } else if (arg == "--guess") {
+        options.passStep = 16;
+        options.guess = true;
+    } else if (arg == "--tile-cache-mb" && hasValue) {
+        options.tileCacheBytes = std::strtoull(argv[++i], nullptr, 10) << 20;
+    } else if (arg == "--tile-store" && hasValue) {
+        options.tileStore = argv[++i];
+    } else if (arg == "--aa" && hasValue) {
+        options.antialias = std::atoi(argv[++i]);
+    } else if (arg == "--distance") {
+        options.distance = true;
+    } else if (arg == "--verify") {
+        options.verify = true;
+    } else {
+        return false;
+    }
+    return true;
+}
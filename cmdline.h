@@ -0,0 +1,25 @@
+#pragma once
+
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+#include "cpurenderer.h"
+
+// Command line flags of the CPU renderer, shared by the viewer and the batch renderer. Takes argv[i] if it is one of
+// them and moves i past its argument, returns false for anything else.
+bool parseCpuOption(int argc, char *argv[], int &i, CpuRenderer::Options &options);
@@ -18,7 +18,9 @@
 #pragma once
 
 #include <array>
+#include <charconv>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <limits>
 
@@ -52,6 +54,24 @@ namespace colormap {
             return os.write(reinterpret_cast<char const *>(&val), sizeof(T));
         }
 
+        // The same bytes as write(os) and the same text as operator<< into
+        // a buffer of at least write_size or print_size chars, both return
+        // the end of the output.
+        static constexpr size_t channel_count = 1;
+        static constexpr size_t write_size = sizeof(T);
+        static constexpr size_t print_size = std::numeric_limits<long>::digits10 + 3;
+
+        char * write (char * buf) const {
+            std::memcpy(buf, &val, sizeof(T));
+            return buf + sizeof(T);
+        }
+
+        char * print (char * buf) const {
+            buf = std::to_chars(buf, buf + print_size, long(val)).ptr;
+            *buf = ' ';
+            return buf + 1;
+        }
+
         const T& getValue() const { return val; }
         T& getValue() { return val; }
 
@@ -88,6 +108,22 @@ namespace colormap {
             return os;
         }
 
+        static constexpr size_t channel_count = N;
+        static constexpr size_t write_size = N * color<space::grayscale,T>::write_size;
+        static constexpr size_t print_size = N * color<space::grayscale,T>::print_size;
+
+        char * write (char * buf) const {
+            for (auto const& ch : channels)
+                buf = ch.write(buf);
+            return buf;
+        }
+
+        char * print (char * buf) const {
+            for (auto const& ch : channels)
+                buf = ch.print(buf);
+            return buf;
+        }
+
         friend std::ostream & operator<< (std::ostream & os, basic_color const& c) {
             for (auto const& ch : c.channels)
                 os << ch;
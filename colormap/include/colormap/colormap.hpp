@@ -22,4 +22,5 @@
 #include <colormap/palettes.hpp>
 #include <colormap/pixmap.hpp>
 
+#include <colormap/itadpt/block_map_iterator_adapter.hpp>
 #include <colormap/itadpt/map_iterator_adapter.hpp>
@@ -22,9 +22,9 @@
 #include <functional>
 #include <initializer_list>
 #include <iterator>
-#include <memory>
 #include <stdexcept>
 #include <type_traits>
+#include <vector>
 
 
 namespace colormap {
@@ -34,6 +34,38 @@ enum class major_order {
     col
 };
 
+template <typename Iterator>
+struct subrange {
+    Iterator begin () const {
+        return first;
+    }
+    Iterator end () const {
+        return last;
+    }
+    size_t size () const {
+        return last - first;
+    }
+    Iterator first;
+    Iterator last;
+};
+
+// `parts` contiguous slices of [first, first + size) of about equal size, in
+// order, e.g. one per thread
+template <typename Iterator>
+std::vector<subrange<Iterator>> split (Iterator first, size_t size, size_t parts) {
+    using difference_type = typename std::iterator_traits<Iterator>::difference_type;
+    parts = std::max<size_t>(1, std::min(parts, size));
+    std::vector<subrange<Iterator>> slices;
+    slices.reserve(parts);
+    Iterator begin = first;
+    for (size_t k = 1; k <= parts; ++k) {
+        Iterator end = first + difference_type(size * k / parts);
+        slices.push_back({begin, end});
+        begin = end;
+    }
+    return slices;
+}
+
 template <size_t dim, major_order order = major_order::row, typename T = double,
           typename = typename std::enable_if<std::is_floating_point<T>::value>::type>
 struct grid {
@@ -41,58 +73,41 @@ struct grid {
     using base_iterator = typename base_grid::const_iterator;
     using range_t = typename base_grid::range_t;
 
+    // Besides the 1-d iterators of the axes the iterator keeps the flat index
+    // of the point, so jumps, distances and comparisons are O(1) and the
+    // coordinates are always computed from the indices.
     struct const_iterator {
         typedef std::array<T, dim> value_type;
         typedef long difference_type;
         typedef value_type reference;
-        typedef std::unique_ptr<value_type> pointer;
-        typedef std::bidirectional_iterator_tag iterator_category;
+        struct pointer {
+            value_type const* operator-> () const {
+                return &p;
+            }
+            value_type p;
+        };
+        typedef std::random_access_iterator_tag iterator_category;
+        const_iterator () : its{}, n(0) {}
         const_iterator & operator++ () {
-            if (order == major_order::row) {
-                auto itit = its.rbegin();
-                auto lastit = its.rend();
-                --lastit;
-                ++(*itit);
-                while (itit->is_end() && itit != lastit) {
-                    itit->reset();
-                    ++itit;
-                    ++(*itit);
-                }
-            } else {
-                auto itit = its.begin();
-                auto lastit = its.end();
-                --lastit;
-                ++(*itit);
-                while (itit->is_end() && itit != lastit) {
-                    itit->reset();
-                    ++itit;
-                    ++(*itit);
-                }
+            ++n;
+            size_t k = 0;
+            ++its[axis(k)];
+            while (its[axis(k)].is_end() && k + 1 < dim) {
+                its[axis(k)].reset();
+                ++k;
+                ++its[axis(k)];
             }
             return *this;
         }
         const_iterator & operator-- () {
-            if (order == major_order::row) {
-                auto itit = its.rbegin();
-                auto lastit = its.rend();
-                --lastit;
-                --(*itit);
-                while (itit->is_begin() && itit != lastit) {
-                    itit->set_to_end();
-                    ++itit;
-                    --(*itit);
-                }
-            } else {
-                auto itit = its.begin();
-                auto lastit = its.end();
-                --lastit;
-                --(*itit);
-                while (itit->is_begin() && itit != lastit) {
-                    itit->set_to_end();
-                    ++itit;
-                    --(*itit);
-                }
+            --n;
+            size_t k = 0;
+            while (its[axis(k)].is_begin() && k + 1 < dim) {
+                its[axis(k)].set_to_end();
+                --its[axis(k)];
+                ++k;
             }
+            --its[axis(k)];
             return *this;
         }
         const_iterator operator++ (int) {
@@ -105,51 +120,69 @@ struct grid {
             --(*this);
             return old;
         }
+        const_iterator & operator+= (difference_type j) {
+            n += j;
+            difference_type k = n;
+            for (size_t d = 0; d + 1 < dim; ++d) {
+                auto & it = its[axis(d)];
+                difference_type N = it.size();
+                it += k % N - it.index();
+                k /= N;
+            }
+            auto & it = its[axis(dim - 1)];
+            it += k - it.index();
+            return *this;
+        }
+        const_iterator & operator-= (difference_type j) {
+            return *this += -j;
+        }
         template <size_t d, typename = typename std::enable_if<(d < dim)>::type>
         const_iterator & move_forward () {
-            if (order == major_order::row)
-                its.rbegin()[d].move_forward();
-            else
-                its.begin()[d].move_forward();
+            its[axis(d)].move_forward();
+            n = flat_index();
             return *this;
         }
         template <size_t d, typename = typename std::enable_if<(d < dim)>::type>
         const_iterator & move_backward () {
-            if (order == major_order::row)
-                its.rbegin()[d].move_backward();
-            else
-                its.begin()[d].move_backward();
+            its[axis(d)].move_backward();
+            n = flat_index();
             return *this;
         }
         reference operator* () const {
             value_type res;
-            std::transform(its.begin(), its.end(), res.begin(),
-                           [] (auto it) { return *it; });
+            for (size_t d = 0; d < dim; ++d)
+                res[d] = *its[d];
             return res;
         }
         pointer operator-> () const {
-            return pointer(new value_type(**this));
+            return {**this};
         }
-        friend bool operator!= (const_iterator const& lhs, const_iterator const& rhs) {
-            for (size_t i = 0; i < dim; ++i)
-                if (lhs.its[i] != rhs.its[i])
-                    return true;
-            return false;
+        reference operator[] (difference_type j) const {
+            return *(*this + j);
+        }
+        friend const_iterator operator+ (const_iterator it, difference_type j) {
+            return it += j;
+        }
+        friend const_iterator operator+ (difference_type j, const_iterator const& it) {
+            return it + j;
+        }
+        friend const_iterator operator- (const_iterator const& it, difference_type j) {
+            return it + (-j);
+        }
+        friend difference_type operator- (const_iterator const& lhs, const_iterator const& rhs) {
+            return lhs.n - rhs.n;
         }
         friend bool operator== (const_iterator const& lhs, const_iterator const& rhs) {
-            return !(lhs != rhs);
+            return lhs.n == rhs.n;
+        }
+        friend bool operator!= (const_iterator const& lhs, const_iterator const& rhs) {
+            return !(lhs == rhs);
         }
         friend bool operator< (const_iterator const& lhs, const_iterator const& rhs) {
-            if (order == major_order::row) {
-                return std::lexicographical_compare(lhs.its.begin(), lhs.its.end(),
-                                                    rhs.its.begin(), rhs.its.end());
-            } else {
-                return std::lexicographical_compare(lhs.its.rbegin(), lhs.its.rend(),
-                                                    rhs.its.rbegin(), rhs.its.rend());
-            }
+            return lhs.n < rhs.n;
         }
         friend bool operator> (const_iterator const& lhs, const_iterator const& rhs) {
-            return !(lhs < rhs || lhs == rhs);
+            return lhs.n > rhs.n;
         }
         friend bool operator<= (const_iterator const& lhs, const_iterator const& rhs) {
             return !(lhs > rhs);
@@ -163,8 +196,18 @@ struct grid {
         }
         friend grid;
     private:
-        const_iterator () : its{} {};
+        // the axis that is the k-th fastest to change
+        static constexpr size_t axis (size_t k) {
+            return order == major_order::row ? dim - 1 - k : k;
+        }
+        difference_type flat_index () const {
+            difference_type k = 0;
+            for (size_t d = dim; d-- > 0;)
+                k = k * its[axis(d)].size() + its[axis(d)].index();
+            return k;
+        }
         std::array<base_iterator, dim> its;
+        difference_type n;
     };
 
     using grid_point_type = typename const_iterator::value_type;
@@ -174,17 +217,7 @@ struct grid {
     }
 
     const_iterator end () const {
-        const_iterator cp(begin_);
-        if (order == major_order::row) {
-            auto lastit = cp.its.rend();
-            --lastit;
-            lastit->set_to_end();
-        } else {
-            auto lastit = cp.its.end();
-            --lastit;
-            lastit->set_to_end();
-        }
-        return cp;
+        return begin_ + size();
     }
 
     size_t size () const {
@@ -194,6 +227,10 @@ struct grid {
         return prod;
     }
 
+    std::vector<subrange<const_iterator>> split (size_t parts) const {
+        return colormap::split(begin(), size(), parts);
+    }
+
     std::array<size_t, dim> shape () const {
         std::array<size_t, dim> s;
         std::transform(begin_.its.begin(), begin_.its.end(), s.begin(),
@@ -231,21 +268,22 @@ struct grid<1, order, T> {
             throw std::runtime_error("grid needs at least 2 points");
     }
 
+    // The coordinate is recomputed from the index on every move, so it does
+    // not drift and the last point is exactly the end of the range.
     struct const_iterator {
         typedef T value_type;
         typedef long difference_type;
         typedef T const& reference;
         typedef T const* pointer;
         typedef std::random_access_iterator_tag iterator_category;
+        const_iterator () = default;
         const_iterator & operator++ () {
             ++i;
-            x += dx;
-            return *this;
+            return update();
         }
         const_iterator & operator-- () {
             --i;
-            x -= dx;
-            return *this;
+            return update();
         }
         const_iterator operator++ (int) {
             const_iterator old(*this);
@@ -267,27 +305,24 @@ struct grid<1, order, T> {
         template <size_t d = 0, typename = typename std::enable_if<(d == 0)>::type>
         const_iterator & move_backward () {
             if (is_begin())
-                return set_to_end();
+                set_to_end();
             return --(*this);
         }
         const_iterator & operator+= (difference_type j) {
             i += j;
-            x += j * dx;
-            return *this;
+            return update();
         }
         const_iterator & operator-= (difference_type j) {
-            i -= j;
-            x -= j * dx;
-            return *this;
+            return *this += -j;
         }
         bool is_begin () const {
             return i == 0;
         }
         bool is_end () const {
-            return i == N;
+            return i == difference_type(N);
         }
         bool in_bulk () const {
-            return i > 0 && i < N-1;
+            return i > 0 && i < difference_type(N) - 1;
         }
         const_iterator & reset () {
             return *this -= i;
@@ -295,11 +330,14 @@ struct grid<1, order, T> {
         const_iterator & set_to_end () {
             return *this += (N - i);
         }
+        difference_type index () const {
+            return i;
+        }
         size_t size () const {
             return N;
         }
         range_t range () const {
-            return {x - i * dx, x + (N - 1 - i) * dx};
+            return {first, last};
         }
         reference operator* () const {
             return x;
@@ -307,10 +345,16 @@ struct grid<1, order, T> {
         pointer operator-> () const {
             return &x;
         }
+        value_type operator[] (difference_type j) const {
+            return *(*this + j);
+        }
         friend const_iterator operator+ (const_iterator const& it, difference_type j) {
             const_iterator cp(it);
             return cp += j;
         }
+        friend const_iterator operator+ (difference_type j, const_iterator const& it) {
+            return it + j;
+        }
         friend const_iterator operator- (const_iterator const& it, difference_type j) {
             return it + (-j);
         }
@@ -338,9 +382,17 @@ struct grid<1, order, T> {
         template <size_t, major_order, typename, typename>
         friend struct grid;
     private:
-        const_iterator () = default;
         const_iterator (difference_type i, range_t range, size_t N)
-            : dx((range.second - range.first) / (N-1)), i(i), N(N), x(range.first + i * dx) {}
+            : first(range.first), last(range.second),
+              dx((range.second - range.first) / (N-1)), i(i), N(N) {
+            update();
+        }
+        const_iterator & update () {
+            x = i == difference_type(N) - 1 ? last : first + i * dx;
+            return *this;
+        }
+        T first;
+        T last;
         T dx;
         difference_type i;
         size_t N;
@@ -367,8 +419,12 @@ struct grid<1, order, T> {
         return N;
     }
 
+    std::vector<subrange<const_iterator>> split (size_t parts) const {
+        return colormap::split(begin(), size(), parts);
+    }
+
     range_t range () const {
-        return { *front(), *back() };
+        return { front(), back() };
     }
 
 private:
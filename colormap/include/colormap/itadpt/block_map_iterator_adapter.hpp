@@ -0,0 +1,228 @@
+// colormap -- color palettes, map iterators, grids, and PPM export
+// Copyright (C) 2018-2019  Jonas Greitemann
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace colormap {
+namespace itadpt {
+
+    // A functor that maps whole blocks provides
+    //   void apply (Domain const* in, size_t n, Value* out) const;
+    // like colormap::map does. Any other functor is called per element.
+    template <typename Functor, typename Domain, typename Value, typename = void>
+    struct has_block_apply : std::false_type {};
+
+    template <typename Functor, typename Domain, typename Value>
+    struct has_block_apply<Functor, Domain, Value,
+                           std::void_t<decltype(std::declval<Functor &>().apply(std::declval<Domain const*>(),
+                                                                                size_t(),
+                                                                                std::declval<Value*>()))>>
+        : std::true_type {};
+
+    // the value type of a functor callable per element, else its value_type
+    template <typename Functor, typename Domain, typename = void>
+    struct block_result {
+        typedef typename Functor::value_type type;
+    };
+
+    template <typename Functor, typename Domain>
+    struct block_result<Functor, Domain, std::enable_if_t<std::is_invocable<Functor &, Domain>::value>> {
+        typedef std::invoke_result_t<Functor &, Domain> type;
+    };
+
+    template <typename Functor, typename Domain, typename Value>
+    void apply_block (Functor & f, Domain const* in, size_t n, Value* out) {
+        if constexpr (has_block_apply<Functor, Domain, Value>::value) {
+            f.apply(in, n, out);
+        } else {
+            for (size_t i = 0; i < n; ++i)
+                out[i] = f(in[i]);
+        }
+    }
+
+    // Input iterator which maps block_size elements of the base iterator at a
+    // time and hands out the buffered values. block() and block_length()
+    // expose the rest of the current block for consumers like pixmap.
+    template <typename BaseIterator, typename Functor, size_t block_size = 64>
+    struct block_map_iterator_adapter {
+        typedef typename std::iterator_traits<BaseIterator>::value_type domain_type;
+        typedef typename block_result<Functor, domain_type>::type value_type;
+        typedef typename std::iterator_traits<BaseIterator>::difference_type difference_type;
+        typedef value_type const& reference;
+        typedef value_type const* pointer;
+        typedef std::input_iterator_tag iterator_category;
+
+        block_map_iterator_adapter ()
+            : base(), functor_ptr(nullptr), index(0), size(0), pos(0), count(0) {}
+
+        // it is the index-th of size elements
+        block_map_iterator_adapter (BaseIterator it, size_t index, size_t size, Functor & f)
+            : base(it), functor_ptr(&f), index(index), size(size), pos(0), count(0) {
+            fill();
+        }
+
+        reference operator* () const {
+            return out[pos];
+        }
+
+        pointer operator-> () const {
+            return &out[pos];
+        }
+
+        block_map_iterator_adapter & operator++ () {
+            return advance_in_block(1);
+        }
+
+        block_map_iterator_adapter operator++ (int) {
+            block_map_iterator_adapter old(*this);
+            ++(*this);
+            return old;
+        }
+
+        value_type const* block () const {
+            return out.data() + pos;
+        }
+
+        size_t block_length () const {
+            return count - pos;
+        }
+
+        // k <= block_length()
+        block_map_iterator_adapter & advance_in_block (size_t k) {
+            index += k;
+            pos += k;
+            if (pos == count)
+                fill();
+            return *this;
+        }
+
+        friend bool operator== (block_map_iterator_adapter const& lhs, block_map_iterator_adapter const& rhs) {
+            return lhs.index == rhs.index;
+        }
+
+        friend bool operator!= (block_map_iterator_adapter const& lhs, block_map_iterator_adapter const& rhs) {
+            return !(lhs == rhs);
+        }
+
+    private:
+        void fill () {
+            pos = 0;
+            count = std::min(block_size, size - index);
+            if (count == 0)
+                return;
+            std::array<domain_type, block_size> in;
+            for (size_t k = 0; k < count; ++k, ++base)
+                in[k] = *base;
+            apply_block(*functor_ptr, in.data(), count, out.data());
+        }
+
+        BaseIterator base; // first element after the block
+        Functor * functor_ptr;
+        size_t index;
+        size_t size;
+        size_t pos;
+        size_t count;
+        std::array<value_type, block_size> out;
+    };
+
+    template <typename Iterator, typename = void>
+    struct is_block_iterator : std::false_type {};
+
+    template <typename Iterator>
+    struct is_block_iterator<Iterator, std::void_t<decltype(std::declval<Iterator const&>().block_length())>>
+        : std::true_type {};
+
+    // pointers and vector iterators
+    template <typename Iterator, typename Value = typename std::iterator_traits<Iterator>::value_type>
+    struct is_contiguous_iterator
+        : std::integral_constant<bool, std::is_pointer<Iterator>::value
+                                       || std::is_same<Iterator, typename std::vector<Value>::iterator>::value
+                                       || std::is_same<Iterator, typename std::vector<Value>::const_iterator>::value> {};
+
+    // Calls consume(value_type const* values, size_t k) on consecutive runs
+    // of the n elements starting at it and returns the iterator past them.
+    // Block iterators hand out their buffers and contiguous storage is
+    // passed as is, the elements of any other iterator are copied into a
+    // buffer first.
+    template <typename Iterator, typename Consumer>
+    Iterator for_each_block (Iterator it, size_t n, Consumer && consume) {
+        if constexpr (is_contiguous_iterator<Iterator>::value) {
+            if (n > 0)
+                consume(&*it, n);
+            std::advance(it, n);
+        } else if constexpr (is_block_iterator<Iterator>::value) {
+            while (n > 0) {
+                size_t k = std::min(n, it.block_length());
+                consume(it.block(), k);
+                it.advance_in_block(k);
+                n -= k;
+            }
+        } else {
+            std::array<typename std::iterator_traits<Iterator>::value_type, 64> buf;
+            while (n > 0) {
+                size_t k = std::min(n, buf.size());
+                for (size_t i = 0; i < k; ++i, ++it)
+                    buf[i] = *it;
+                consume(buf.data(), k);
+                n -= k;
+            }
+        }
+        return it;
+    }
+
+    template <typename Container, typename Functor, size_t block_size = 64>
+    struct block_mapped {
+        typedef Container container_type;
+        typedef Functor map_type;
+        typedef block_map_iterator_adapter<decltype(std::begin(std::declval<Container const&>())),
+                                           Functor, block_size> const_iterator;
+        typedef typename const_iterator::value_type value_type;
+
+        block_mapped (Container const& c, Functor & f)
+            : container(c), functor(f) {}
+
+        const_iterator begin () const {
+            return const_iterator(std::begin(container), 0, size(), functor);
+        }
+
+        const_iterator end () const {
+            return const_iterator(std::end(container), size(), size(), functor);
+        }
+
+        size_t size () const {
+            return std::size(container);
+        }
+    private:
+        Container const& container;
+        Functor & functor;
+    };
+
+    template <size_t block_size = 64, typename Container, typename Functor>
+    block_mapped<Container, Functor, block_size> block_map (Container const& c, Functor & f) {
+        return block_mapped<Container, Functor, block_size>(c, f);
+    }
+
+}
+}
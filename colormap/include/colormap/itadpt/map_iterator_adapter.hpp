@@ -18,7 +18,6 @@
 #pragma once
 
 #include <iterator>
-#include <memory>
 #include <type_traits>
 #include <utility>
 
@@ -42,7 +41,12 @@ namespace itadpt {
                                                                    // in C++17
         typedef typename std::iterator_traits<BaseIterator>::difference_type difference_type;
         typedef value_type reference;
-        typedef std::unique_ptr<value_type> pointer;
+        struct pointer {
+            value_type const* operator-> () const {
+                return &value;
+            }
+            value_type value;
+        };
         typedef typename std::iterator_traits<BaseIterator>::iterator_category iterator_category;
 
         template <typename Tag = iterator_category,
@@ -57,7 +61,7 @@ namespace itadpt {
         }
 
         pointer operator-> () const {
-            return pointer(new value_type((*functor_ptr)(*base)));
+            return {(*functor_ptr)(*base)};
         }
 
         friend bool operator== (map_iterator_adapter const& lhs, map_iterator_adapter const& rhs) {
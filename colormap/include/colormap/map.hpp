@@ -17,65 +17,135 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
 #include <initializer_list>
+#include <iterator>
 #include <limits>
 #include <map>
+#include <memory>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 #include <colormap/color.hpp>
 
 
 namespace colormap {
 
+    // The supports are compiled into flat arrays on construction and shared
+    // (immutable) between copies and rescaled maps. Besides the exact
+    // interpolation of operator(), sample() and apply() look colors up in a
+    // table of lut_size evenly spaced samples, which is within one level of
+    // the exact color per channel.
     template <typename Color>
     struct map {
         using color_type = Color;
 
-        map (std::initializer_list<Color> il) : range {0, 1} {
-            double step = 1. / (il.size() - 1);
+        static constexpr size_t lut_size = 4096;
+
+        map (std::initializer_list<Color> il) : map(il.begin(), il.end()) {}
+
+        map (std::initializer_list<std::pair<double,Color>> il)
+            : map(il.begin(), il.end()) {}
+
+        // evenly spaced colors
+        template <typename ForwardIterator,
+                  typename std::enable_if<std::is_convertible<typename std::iterator_traits<ForwardIterator>::value_type, Color>::value, int>::type = 0>
+        map (ForwardIterator first, ForwardIterator last) : range {0, 1} {
+            double step = 1. / (std::distance(first, last) - 1);
             size_t i = 0;
-            for (Color const& c : il)
-                supports[(i++) * step] = c;
+            std::map<double, Color> supports;
+            for (; first != last; ++first)
+                supports[(i++) * step] = *first;
+            compile(supports);
         }
 
-        map (std::initializer_list<std::pair<double,Color>> il) {
+        // (position, color) pairs, the positions are normalized to [0, 1]
+        template <typename ForwardIterator,
+                  typename std::enable_if<std::is_convertible<typename std::iterator_traits<ForwardIterator>::value_type, std::pair<double,Color>>::value, int>::type = 0>
+        map (ForwardIterator first, ForwardIterator last) {
             range = { std::numeric_limits<double>::max(),
                       std::numeric_limits<double>::min() };
-            for (auto p : il) {
-                double & val = p.first;
+            for (auto it = first; it != last; ++it) {
+                double val = it->first;
                 if (range.first > val) range.first = val;
                 if (range.second < val) range.second = val;
             }
-            for (auto p : il) {
-                double & val = p.first;
-                Color & c = p.second;
-                supports[(val - range.first) / (range.second - range.first)] = c;
-            }
+            std::map<double, Color> supports;
+            for (; first != last; ++first)
+                supports[(first->first - range.first) / (range.second - range.first)] = first->second;
             range = {0., 1.};
+            compile(supports);
         }
 
         map rescale (double x_min, double x_max) const {
             map rescaled(*this);
             rescaled.range = {x_min, x_max};
+            rescaled.lut_scale = (lut_size - 1) / (x_max - x_min);
             return rescaled;
         }
 
         Color operator() (double x) const {
-            x = (x - range.first) / (range.second - range.first);
-            auto a = supports.lower_bound(x);
-            auto b = supports.upper_bound(x);
-            if (a == supports.end())
-                return (--a)->second;
-            if (b == supports.end() || a == supports.begin() || a->first == x)
-                return a->second;
-            --a;
-            double mix = (x - a->first) / (b->first - a->first);
-            return a->second.mix(b->second, mix);
+            return interpolate(*supports, (x - range.first) / (range.second - range.first));
+        }
+
+        Color sample (double x) const {
+            return supports->lut[lut_index(x)];
+        }
+
+        // out[i] = sample(x[i]) for i < n
+        void apply (double const* x, size_t n, Color* out) const {
+            Color const* lut = supports->lut.data();
+            for (size_t i = 0; i < n; ++i)
+                out[i] = lut[lut_index(x[i])];
         }
 
     private:
-        std::map<double, Color> supports;
+        struct compiled {
+            std::vector<double> x;
+            std::vector<Color> colors;
+            std::vector<Color> lut;
+        };
+
+        static Color interpolate (compiled const& c, double x) {
+            // first support not below x; before the first and after the last
+            // support (and for NaN) the color is constant
+            auto a = std::lower_bound(c.x.begin(), c.x.end(), x);
+            if (a == c.x.end())
+                return c.colors.back();
+            size_t i = a - c.x.begin();
+            if (i == 0 || *a == x)
+                return c.colors[i];
+            double mix = (x - c.x[i - 1]) / (*a - c.x[i - 1]);
+            return c.colors[i - 1].mix(c.colors[i], mix);
+        }
+
+        void compile (std::map<double, Color> const& s) {
+            auto c = std::make_shared<compiled>();
+            for (auto const& p : s) {
+                c->x.push_back(p.first);
+                c->colors.push_back(p.second);
+            }
+            c->lut.reserve(lut_size);
+            for (size_t i = 0; i < lut_size; ++i)
+                c->lut.push_back(interpolate(*c, double(i) / (lut_size - 1)));
+            supports = std::move(c);
+            lut_scale = (lut_size - 1) / (range.second - range.first);
+        }
+
+        size_t lut_index (double x) const {
+            // rounded to the nearest entry, NaN goes to the first one like in
+            // operator()
+            double t = (x - range.first) * lut_scale + .5;
+            t = t > 0. ? t : 0.;
+            t = t < lut_size - .5 ? t : lut_size - .5;
+            return size_t(int(t));
+        }
+
+        std::shared_ptr<compiled const> supports;
         std::pair<double,double> range;
+        double lut_scale;
     };
 
 }
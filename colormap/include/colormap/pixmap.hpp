@@ -17,11 +17,17 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <iterator>
 #include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
 
 #include <colormap/color.hpp>
+#include <colormap/itadpt/block_map_iterator_adapter.hpp>
 
 
 namespace colormap {
@@ -37,27 +43,67 @@ namespace colormap {
         pixmap (ForwardIterator begin, std::array<size_t,2> const& alt_shape)
             : begin(begin), shape{alt_shape[0], alt_shape[1]} {};
 
+        // Both writers format the pixels into a buffer of buffer_size chars
+        // and hand it to the stream whenever it is full. Contiguous storage
+        // of colors without padding is written directly by write_binary.
+        static constexpr size_t buffer_size = 1 << 16;
+
         std::ostream & write_ascii (std::ostream & os) const {
-            ForwardIterator it(begin);
             os << header(false);
-            for (size_t i = 0; i < shape.second; ++i) {
-                for (size_t j = 0; j < shape.first; ++j, ++it) {
-                    os << *it;
+            std::vector<char> buf(buffer_size);
+            char * out = buf.data();
+            auto reserve = [&] (size_t k) {
+                if (size_t(buf.data() + buf.size() - out) < k) {
+                    os.write(buf.data(), out - buf.data());
+                    out = buf.data();
                 }
-                os << '\n';
+            };
+            ForwardIterator it(begin);
+            for (size_t i = 0; i < shape.second; ++i) {
+                it = itadpt::for_each_block(it, shape.first, [&] (color_type const* pix, size_t n) {
+                    for (size_t j = 0; j < n; ++j) {
+                        reserve(color_type::print_size);
+                        out = pix[j].print(out);
+                    }
+                });
+                reserve(1);
+                *out++ = '\n';
             }
+            os.write(buf.data(), out - buf.data());
             return os;
         }
 
         std::ostream & write_binary (std::ostream & os) const {
-            ForwardIterator it(begin);
             std::string hdr = header(true);
             os.write(hdr.c_str(), hdr.size());
-            for (size_t i = 0; i < shape.second; ++i) {
-                for (size_t j = 0; j < shape.first; ++j, ++it) {
-                    color_type pix = *it;
-                    pix.write(os);
-                }
+            size_t n = shape.first * shape.second;
+            if constexpr (raw_storage) {
+                if (n > 0)
+                    os.write(reinterpret_cast<char const *>(&*begin), n * sizeof(color_type));
+            } else {
+                std::vector<char> buf(buffer_size);
+                char * out = buf.data();
+                auto reserve = [&] (size_t k) {
+                    if (size_t(buf.data() + buf.size() - out) < k) {
+                        os.write(buf.data(), out - buf.data());
+                        out = buf.data();
+                    }
+                };
+                itadpt::for_each_block(begin, n, [&] (color_type const* pix, size_t k) {
+                    for (size_t j = 0; j < k;) {
+                        reserve(color_type::write_size);
+                        size_t m = std::min(k - j, size_t(buf.data() + buf.size() - out) / color_type::write_size);
+                        if constexpr (packed) {
+                            std::memcpy(out, pix + j, m * sizeof(color_type));
+                            out += m * sizeof(color_type);
+                        } else {
+                            for (size_t i = 0; i < m; ++i)
+                                out = pix[j + i].write(out);
+                        }
+                        j += m;
+                    }
+                });
+                os.write(buf.data(), out - buf.data());
             }
             return os;
         }
@@ -73,6 +119,12 @@ namespace colormap {
         }
 
     private:
+        // the memory of a color is what it writes, so is the memory of the
+        // pixels in contiguous storage
+        static constexpr bool packed = std::is_trivially_copyable<color_type>::value
+            && sizeof(color_type) == color_type::write_size;
+        static constexpr bool raw_storage = packed && itadpt::is_contiguous_iterator<ForwardIterator>::value;
+
         ForwardIterator begin;
         shape_type shape;
 
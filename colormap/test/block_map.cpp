@@ -0,0 +1,115 @@
+// colormap -- color palettes, map iterators, grids, and PPM export
+// Copyright (C) 2018-2019  Jonas Greitemann
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include <doctest/doctest.h>
+
+#include <colormap/grid.hpp>
+#include <colormap/palettes.hpp>
+#include <colormap/pixmap.hpp>
+#include <colormap/itadpt/block_map_iterator_adapter.hpp>
+#include <colormap/itadpt/map_iterator_adapter.hpp>
+
+#include <sstream>
+#include <vector>
+
+
+using namespace colormap;
+
+namespace {
+    using rgb = color<space::rgb>;
+
+    bool equal (rgb const& a, rgb const& b) {
+        return a.getRed().getValue() == b.getRed().getValue()
+            && a.getGreen().getValue() == b.getGreen().getValue()
+            && a.getBlue().getValue() == b.getBlue().getValue();
+    }
+
+    // block-only functor, records the block sizes it is called with
+    struct square {
+        typedef double value_type;
+        void apply (double const* in, size_t n, double* out) {
+            for (size_t i = 0; i < n; ++i)
+                out[i] = in[i] * in[i];
+            calls.push_back(n);
+        }
+        std::vector<size_t> calls;
+    };
+
+}
+
+TEST_CASE("block-apply") {
+    std::vector<double> x(150);
+    for (size_t i = 0; i < x.size(); ++i)
+        x[i] = i;
+    square f;
+    auto m = itadpt::block_map<32>(x, f);
+    size_t i = 0;
+    for (double y : m) {
+        CHECK(y == x[i] * x[i]);
+        ++i;
+    }
+    CHECK(i == x.size());
+    CHECK(f.calls == std::vector<size_t>{32, 32, 32, 32, 22});
+}
+
+TEST_CASE("scalar-fallback") {
+    grid<2> g {{13, {0, 1}}, {17, {-1, 1}}};
+    auto f = [] (std::array<double, 2> p) { return p[0] - 2 * p[1]; };
+    auto scalar = itadpt::map(g, f);
+    auto block = itadpt::block_map<8>(g, f);
+    CHECK(std::equal(scalar.begin(), scalar.end(), block.begin(), block.end()));
+}
+
+TEST_CASE("for-each-block") {
+    std::vector<float> x(1000);
+    for (size_t i = 0; i < x.size(); ++i)
+        x[i] = i / 999.f;
+    auto pal = palettes.at("viridis");
+    auto check = [&] (auto it) {
+        size_t i = 0;
+        it = itadpt::for_each_block(it, 300, [&] (auto const* c, size_t n) {
+            for (size_t j = 0; j < n; ++j, ++i)
+                CHECK(equal(c[j], pal(x[i])));
+        });
+        CHECK(i == 300);
+        CHECK(equal(*it, pal(x[300])));
+    };
+    check(itadpt::map(x, pal).begin());
+    check(itadpt::block_map(x, pal).begin());
+}
+
+TEST_CASE("pixmap") {
+    std::vector<double> x(37 * 23);
+    for (size_t i = 0; i < x.size(); ++i)
+        x[i] = (i % 37) / 36. * (i / 37) / 22.;
+    // colormap::map::apply() gives the colors of sample()
+    auto pal = palettes.at("inferno");
+    auto sample = [&] (double v) { return pal.sample(v); };
+    auto scalar = itadpt::map(x, sample);
+    auto block = itadpt::block_map(x, pal);
+    pixmap<decltype(scalar.begin())> spix(scalar.begin(), std::make_pair(37, 23));
+    pixmap<decltype(block.begin())> bpix(block.begin(), std::make_pair(37, 23));
+    std::ostringstream sbin, bbin, sasc, basc;
+    spix.write_binary(sbin);
+    bpix.write_binary(bbin);
+    spix.write_ascii(sasc);
+    bpix.write_ascii(basc);
+    CHECK(sbin.str() == bbin.str());
+    CHECK(sasc.str() == basc.str());
+}
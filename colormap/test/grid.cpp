@@ -20,6 +20,11 @@
 #include <doctest/doctest.h>
 
 #include <colormap/grid.hpp>
+#include <colormap/itadpt/map_iterator_adapter.hpp>
+
+#include <algorithm>
+#include <execution>
+#include <vector>
 
 
 using namespace colormap;
@@ -88,3 +93,71 @@ TEST_CASE("ordering-col-major") {
         }
     }
 }
+
+TEST_CASE("1d-grid-exact") {
+    grid<1> g {100001, {-1.3, 0.7}};
+    CHECK(*(g.end() - 1) == 0.7);
+    double dx = 2. / 100000;
+    size_t i = 0;
+    for (auto it = g.begin(); it != g.end() - 1; ++it, ++i)
+        CHECK(*it == -1.3 + i * dx);
+}
+
+TEST_CASE("random-access-row-major") {
+    grid<3> g {{4, {0, 10}}, {5, {-1, 1}}, {3, {2, 3}}};
+    long i = 0;
+    for (auto it = g.begin(); it != g.end(); ++it, ++i) {
+        CHECK(it - g.begin() == i);
+        CHECK(g.begin() + i == it);
+        CHECK(g.end() - (long(g.size()) - i) == it);
+        CHECK(g.begin()[i] == *it);
+        CHECK((it + 1) - 1 == it);
+    }
+    CHECK(i == long(g.size()));
+    for (auto it = g.end(); it != g.begin(); ) {
+        --i;
+        --it;
+        CHECK(*it == g.begin()[i]);
+    }
+}
+
+TEST_CASE("random-access-col-major") {
+    grid<3, major_order::col> g {{4, {0, 10}}, {5, {-1, 1}}, {3, {2, 3}}};
+    long i = 0;
+    for (auto it = g.begin(); it != g.end(); ++it, ++i) {
+        CHECK(it - g.begin() == i);
+        CHECK(g.begin()[i] == *it);
+        CHECK(it->at(0) == (*it)[0]);
+    }
+    auto it = g.begin();
+    it.move_forward<1>();
+    CHECK(it - g.begin() == 4);
+    it.move_backward<0>();
+    CHECK(it - g.begin() == 7);
+}
+
+TEST_CASE("split") {
+    grid<2> g {{7, {0, 1}}, {11, {0, 1}}};
+    for (size_t parts : {1, 2, 3, 5, 76, 77, 100}) {
+        auto slices = g.split(parts);
+        CHECK(slices.size() == std::min<size_t>(parts, g.size()));
+        auto next = g.begin();
+        for (auto const& s : slices) {
+            CHECK(s.begin() == next);
+            CHECK(s.size() >= g.size() / slices.size());
+            CHECK(s.size() <= g.size() / slices.size() + 1);
+            next = s.end();
+        }
+        CHECK(next == g.end());
+    }
+}
+
+TEST_CASE("parallel-map") {
+    grid<2, major_order::col> g {{301, {-2.5, 1.}}, {201, {-1., 1.}}};
+    auto f = [] (std::array<double, 2> p) { return p[0] * p[0] - p[1]; };
+    auto mapped = itadpt::map(g, f);
+    std::vector<double> serial, parallel(mapped.size());
+    std::copy(mapped.begin(), mapped.end(), std::back_inserter(serial));
+    std::copy(std::execution::par_unseq, mapped.begin(), mapped.end(), parallel.begin());
+    CHECK(serial == parallel);
+}
@@ -18,6 +18,7 @@
 #include <algorithm>
 #include <cmath>
 #include <complex>
+#include <execution>
 #include <fstream>
 #include <iostream>
 #include <utility>
@@ -27,6 +28,7 @@
 #include <colormap/grid.hpp>
 #include <colormap/palettes.hpp>
 #include <colormap/pixmap.hpp>
+#include <colormap/itadpt/block_map_iterator_adapter.hpp>
 #include <colormap/itadpt/map_iterator_adapter.hpp>
 
 
@@ -65,17 +67,18 @@ int main () {
     // Result is a `mapped` object that behave like a container.
     auto val_map = itadpt::map(g, mandelbrot);
 
-    // collect the function values -- not required but faster here
-    std::vector<double> val;
-    std::copy(val_map.begin(), val_map.end(), std::back_inserter(val));
+    // collect the function values -- not required but faster here. Grid
+    // iterators are random access, so this runs on all cores.
+    std::vector<double> val(val_map.size());
+    std::copy(std::execution::par_unseq, val_map.begin(), val_map.end(), val.begin());
 
     // find the maximum value
     double max = *std::max_element(val.begin(), val.end());
 
     // get a colormap and rescale it
     auto pal = palettes.at("inferno").rescale(1, max);
-    // and use it to map the values to colors
-    auto pix = itadpt::map(val, pal);
+    // and use it to map the values to colors, a block of values at a time
+    auto pix = itadpt::block_map(val, pal);
 
     // Construct a PPM object from the `mapped` object `pix`. Color space is
     // inferred from color type of pix. "inferno" is an RGB palette, so `pmap`
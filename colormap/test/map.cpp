@@ -0,0 +1,87 @@
+// colormap -- color palettes, map iterators, grids, and PPM export
+// Copyright (C) 2018-2019  Jonas Greitemann
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include <doctest/doctest.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+#include <colormap/map.hpp>
+#include <colormap/palettes.hpp>
+
+
+using namespace colormap;
+
+namespace {
+    using rgb = color<space::rgb>;
+
+    bool within_one (rgb const& a, rgb const& b) {
+        return std::abs(a.getRed().getValue() - b.getRed().getValue()) <= 1
+            && std::abs(a.getGreen().getValue() - b.getGreen().getValue()) <= 1
+            && std::abs(a.getBlue().getValue() - b.getBlue().getValue()) <= 1;
+    }
+
+    bool equal (rgb const& a, rgb const& b) {
+        return a.getRed().getValue() == b.getRed().getValue()
+            && a.getGreen().getValue() == b.getGreen().getValue()
+            && a.getBlue().getValue() == b.getBlue().getValue();
+    }
+}
+
+TEST_CASE("map-interpolation") {
+    // supports at 0, 1 and 4, normalized to 0, 1/4 and 1
+    map<rgb> m { {0., rgb {0, 0, 0}}, {1., rgb {200, 100, 0}}, {4., rgb {0, 100, 200}} };
+    CHECK(equal(m(-1.), rgb {0, 0, 0}));
+    CHECK(equal(m(0.), rgb {0, 0, 0}));
+    CHECK(equal(m(.125), rgb {100, 50, 0}));
+    CHECK(equal(m(.25), rgb {200, 100, 0}));
+    CHECK(equal(m(.625), rgb {100, 100, 100}));
+    CHECK(equal(m(1.), rgb {0, 100, 200}));
+    CHECK(equal(m(2.), rgb {0, 100, 200}));
+    CHECK(equal(m(std::numeric_limits<double>::quiet_NaN()), rgb {0, 0, 0}));
+}
+
+TEST_CASE("map-rescale") {
+    auto const& pal = palettes.at("jet");
+    auto rescaled = pal.rescale(10., 20.);
+    for (int i = 0; i <= 100; ++i) {
+        CHECK(equal(rescaled(10. + i / 10.), pal(i / 100.)));
+        CHECK(equal(rescaled.sample(10. + i / 10.), pal.sample(i / 100.)));
+    }
+    // the original is unchanged
+    CHECK(equal(pal(1.), palettes.at("jet")(1.)));
+}
+
+TEST_CASE("map-lookup-table") {
+    std::vector<double> x;
+    for (int i = -100; i <= 10100; ++i)
+        x.push_back(i / 10000.);
+    x.push_back(std::numeric_limits<double>::quiet_NaN());
+    std::vector<rgb> out(x.size());
+    for (auto const& p : palettes) {
+        auto const& pal = palettes.at(p.name);
+        pal.apply(x.data(), x.size(), out.data());
+        for (size_t i = 0; i < x.size(); ++i) {
+            CHECK(equal(out[i], pal.sample(x[i])));
+            CHECK(within_one(out[i], pal(x[i])));
+        }
+    }
+}
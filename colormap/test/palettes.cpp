@@ -15,8 +15,13 @@
 // with this program; if not, write to the Free Software Foundation, Inc.,
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include <doctest/doctest.h>
+
 #include <fstream>
 #include <iostream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -28,13 +33,45 @@
 
 using namespace colormap;
 
-int main () {
+namespace {
+    using rgb = color<space::rgb>;
+
+    bool equal (rgb const& a, rgb const& b) {
+        return a.getRed().getValue() == b.getRed().getValue()
+            && a.getGreen().getValue() == b.getGreen().getValue()
+            && a.getBlue().getValue() == b.getBlue().getValue();
+    }
+}
+
+TEST_CASE("palette-lookup") {
+    CHECK(palettes.size() == 49);
+    CHECK(palettes.contains("inferno"));
+    CHECK(!palettes.contains("infern"));
+    CHECK(palettes.find("zzz") == palettes.end());
+    CHECK_THROWS_AS(palettes.at("nope"), std::out_of_range);
+    // built once
+    CHECK(&palettes.at("viridis") == &palettes.at("viridis"));
+    // rdwhbu has explicit positions, white at 3.5 of 7
+    CHECK(equal(palettes.at("rdwhbu")(.5), rgb {0xff, 0xff, 0xff}));
+    CHECK(equal(palettes.at("jet")(0.), rgb {0, 0, 127}));
+}
+
+TEST_CASE("grayscale") {
+    CHECK(grayscale(0.).getValue() == 0);
+    CHECK(grayscale(1.).getValue() == 255);
+    map<gray> const& m = grayscale;
+    CHECK(&m == &grayscale.get());
+    CHECK(m.rescale(0., 2.)(1.).getValue() == 127);
+}
+
+// all palettes side by side in palettes.ppm
+TEST_CASE("palette-image") {
     size_t M = 25;
     std::vector<std::string> names;
     std::vector<decltype(palettes)::mapped_type> pals;
-    for (auto pair : palettes) {
-        names.push_back(pair.first);
-        pals.push_back(pair.second);
+    for (auto const& p : palettes) {
+        names.emplace_back(p.name);
+        pals.push_back(palettes.at(p.name));
         std::cout << names.back() << std::endl;
     }
 
@@ -0,0 +1,103 @@
+// colormap -- color palettes, map iterators, grids, and PPM export
+// Copyright (C) 2018-2019  Jonas Greitemann
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include <doctest/doctest.h>
+
+#include <colormap/palettes.hpp>
+#include <colormap/pixmap.hpp>
+#include <colormap/itadpt/block_map_iterator_adapter.hpp>
+#include <colormap/itadpt/map_iterator_adapter.hpp>
+
+#include <cstdint>
+#include <list>
+#include <sstream>
+#include <vector>
+
+
+using namespace colormap;
+
+namespace {
+    const size_t width = 301;
+    const size_t height = 203;
+
+    // one stream call per channel, as the writers used to
+    template <typename Iterator>
+    void check (Iterator begin) {
+        pixmap<Iterator> pmap(begin, std::make_pair(width, height));
+        std::ostringstream binary, ascii;
+        pmap.write_binary(binary);
+        pmap.write_ascii(ascii);
+
+        using color_type = typename pixmap<Iterator>::color_type;
+        std::ostringstream ref_binary, ref_ascii;
+        std::ostringstream hdr;
+        hdr << width << ' ' << height << '\n' << size_t(color_type::depth()) << '\n';
+        bool gray = color_type::color_space() == space::grayscale;
+        ref_binary << (gray ? "P5\n" : "P6\n") << hdr.str();
+        ref_ascii << (gray ? "P2\n" : "P3\n") << hdr.str();
+        Iterator it = begin;
+        for (size_t i = 0; i < height; ++i) {
+            for (size_t j = 0; j < width; ++j, ++it) {
+                color_type c = *it;
+                c.write(ref_binary);
+                ref_ascii << c;
+            }
+            ref_ascii << '\n';
+        }
+        CHECK(binary.str() == ref_binary.str());
+        CHECK(ascii.str() == ref_ascii.str());
+    }
+
+    std::vector<double> ramp () {
+        std::vector<double> x(width * height);
+        for (size_t i = 0; i < x.size(); ++i)
+            x[i] = double(i * 7919 % x.size()) / x.size();
+        return x;
+    }
+}
+
+TEST_CASE("rgb-vector") {
+    auto x = ramp();
+    auto pal = palettes.at("inferno");
+    std::vector<color<space::rgb>> pixels(x.size());
+    pal.apply(x.data(), x.size(), pixels.data());
+    check(pixels.cbegin());
+    check(pixels.data());
+    std::list<color<space::rgb>> list(pixels.begin(), pixels.end());
+    check(list.cbegin());
+}
+
+TEST_CASE("mapped") {
+    auto x = ramp();
+    auto pal = palettes.at("viridis");
+    check(itadpt::map(x, pal).begin());
+    check(itadpt::block_map(x, pal).begin());
+    check(itadpt::block_map(x, grayscale).begin());
+}
+
+TEST_CASE("wide-channels") {
+    std::vector<color<space::grayscale, std::uint16_t>> gray(width * height);
+    std::vector<color<space::rgb, std::uint16_t>> rgb(width * height);
+    for (size_t i = 0; i < gray.size(); ++i) {
+        gray[i] = std::uint16_t(i * 40503);
+        rgb[i] = {std::uint16_t(i), std::uint16_t(i * 3), std::uint16_t(65535 - i)};
+    }
+    check(gray.cbegin());
+    check(rgb.cbegin());
+}
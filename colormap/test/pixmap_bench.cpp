@@ -0,0 +1,104 @@
+// colormap -- color palettes, map iterators, grids, and PPM export
+// Copyright (C) 2018-2019  Jonas Greitemann
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// PPM export throughput of pixmap for colors in a vector and for values
+// mapped through a palette on the fly. The stream copies its output into a
+// scratch buffer instead of a file, so the disk doesn't bound the result.
+// Usage: pixmap_bench [WIDTH [HEIGHT]], 8192 x 8192 by default.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+#include <colormap/palettes.hpp>
+#include <colormap/pixmap.hpp>
+#include <colormap/itadpt/block_map_iterator_adapter.hpp>
+#include <colormap/itadpt/map_iterator_adapter.hpp>
+
+
+using namespace colormap;
+
+namespace {
+    using rgb = color<space::rgb>;
+
+    // copies everything written to it into the same 1 MiB, which is
+    // roughly the cost of handing it to the kernel
+    struct sink_buffer : std::streambuf {
+        size_t bytes () const {
+            return written;
+        }
+
+    protected:
+        std::streamsize xsputn (char const* data, std::streamsize count) override {
+            for (std::streamsize done = 0; done < count;) {
+                size_t chunk = std::min<size_t>(count - done, sink.size());
+                std::memcpy(sink.data(), data + done, chunk);
+                done += chunk;
+            }
+            written += count;
+            return count;
+        }
+
+        int_type overflow (int_type c) override {
+            sink[0] = static_cast<char>(c);
+            ++written;
+            return c;
+        }
+
+    private:
+        std::vector<char> sink = std::vector<char>(1 << 20);
+        size_t written = 0;
+    };
+
+    template <typename Iterator>
+    void measure (char const* name, Iterator begin, size_t width, size_t height, bool binary) {
+        pixmap<Iterator> image(begin, std::make_pair(width, height));
+        sink_buffer buf;
+        std::ostream os(&buf);
+        auto start = std::chrono::steady_clock::now();
+        if (binary)
+            image.write_binary(os);
+        else
+            image.write_ascii(os);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::printf("%-28s %-7s %10.1f ms %8.3f GB/s\n", name, binary ? "binary" : "ascii",
+                    elapsed.count() * 1e3, buf.bytes() / elapsed.count() * 1e-9);
+    }
+}
+
+int main (int argc, char* argv[]) {
+    size_t width = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 8192;
+    size_t height = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : width;
+
+    std::vector<double> x(width * height);
+    for (size_t i = 0; i < x.size(); ++i)
+        x[i] = double(i * 2654435761u % 65521) / 65521;
+    auto const& pal = palettes.at("inferno");
+    std::vector<rgb> colors(x.size());
+    pal.apply(x.data(), x.size(), colors.data());
+
+    std::printf("%zu x %zu\n", width, height);
+    measure("colors in a vector", colors.cbegin(), width, height, true);
+    measure("colors in a vector", colors.cbegin(), width, height, false);
+    measure("itadpt::block_map(palette)", itadpt::block_map(x, pal).begin(), width, height, true);
+    measure("itadpt::map(palette)", itadpt::map(x, pal).begin(), width, height, true);
+}
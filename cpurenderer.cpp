@@ -0,0 +1,1161 @@
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "cpurenderer.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+CpuRenderer::Stats &CpuRenderer::Stats::operator+=(const Stats &o)
+{
+    computedPixels += o.computedPixels;
+    filledPixels += o.filledPixels;
+    mirroredPixels += o.mirroredPixels;
+    cachedPixels += o.cachedPixels;
+    cardioidPixels += o.cardioidPixels;
+    periodicPixels += o.periodicPixels;
+    attractingPixels += o.attractingPixels;
+    antialiasedPixels += o.antialiasedPixels;
+    antialiasSamples += o.antialiasSamples;
+    distantPixels += o.distantPixels;
+    mismatchedPixels += o.mismatchedPixels;
+    return *this;
+}
+
+CpuRenderer::CpuRenderer(unsigned threads, KernelIsa isa)
+    : mPool(threads), mIsa(isa), mKernel(getEscapeKernel(isa)), mDoubleDoubleKernel(getDoubleDoubleKernel(isa)), mScratch(mPool.size())
+    , mTileCache(tileSize, mOptions.tileCacheBytes)
+    , mTileStore(tileSize)
+{
+}
+
+void CpuRenderer::setOptions(const Options &options)
+{
+    // the savers may change the odd pixel, cached tiles are only reused with the same ones
+    mOptions = options;
+    mTileCache.clear();
+    mTileCache.setBudget(options.tileCacheBytes);
+    if (options.tileStore.empty()) {
+        mTileStore.close();
+    } else {
+        mTileStore.open(options.tileStore);
+    }
+}
+
+// inside the main cardioid or the period 2 bulb, both are part of the set
+static bool isInCardioidOrBulb(double re, double im)
+{
+    double im2 = im * im;
+    double x = re - 0.25;
+    double q = x * x + im2;
+    if (q * (q + x) <= 0.25 * im2) {
+        return true;
+    }
+    return (re + 1.0) * (re + 1.0) + im2 <= 0.0625;
+}
+
+static DoubleDouble toDoubleDouble(const FixedPoint &v)
+{
+    double hi = v.toDouble();
+    FixedPoint rest = v;
+    rest -= hi;
+    return { hi, rest.toDouble() };
+}
+
+void CpuRenderer::render(const View &view, IterationBuffer &iterations)
+{
+    beginFrame(view, iterations);
+    while (renderPass(iterations)) {
+    }
+}
+
+void CpuRenderer::beginFrame(const View &view, IterationBuffer &iterations, const IterationBuffer *outer)
+{
+    mView = view;
+    mRequestedView = view;
+    mPrecision = getPrecision(view);
+    if (mPrecision == Precision::Perturbation) {
+        updateReference(view);
+    }
+    setupLattice(view);
+    setupCoordinates(mView, mPrecision, mOptions.snapAxis);
+    mDistances.clear();
+    // counts of another precision would differ along the edges
+    View outerView = view;
+    outerView.planeWidth *= 2;
+    outerView.planeHeight *= 2;
+    mSeeded = outer && mOptions.centeredGrid && !mOptions.logPolar && !mOptions.distance && outer->width == view.width && outer->height == view.height
+        && getPrecision(outerView) == mPrecision;
+    if (!mSeeded) {
+        setupFrame(mOptions, mLattice ? mLatticeFrame : iterations);
+        return;
+    }
+    // previews would overwrite the copied pixels
+    Options options = mOptions;
+    options.passStep = 1;
+    setupFrame(options, iterations);
+    seedFrame(*outer, iterations);
+}
+
+double CpuRenderer::getSpacing(const View &view) const
+{
+    if (mOptions.logPolar) {
+        const double angle = 2 * M_PI / view.width;
+        return view.planeWidth / 2 * std::exp(-angle * (view.height - 0.5)) * angle;
+    }
+    return view.pixelSpacing();
+}
+
+CpuRenderer::Precision CpuRenderer::getPrecision(const View &view) const
+{
+    const double spacing = getSpacing(view);
+    if (view.type == ShaderType::Mandelbrot && spacing < perturbationSpacing) {
+        return Precision::Perturbation;
+    }
+    return spacing < doubleDoubleSpacing ? Precision::DoubleDouble : Precision::Double;
+}
+
+// On the centered grid pixel x is (x - width / 2) spacings from the center; at half the spacing the even ones are
+// exactly the pixels of the frame one octave out (scaling by two is exact), so their counts are the same.
+void CpuRenderer::seedFrame(const IterationBuffer &outer, IterationBuffer &iterations)
+{
+    const int cx = mView.width / 2;
+    const int cy = mView.height / 2;
+    const int x0 = cx % 2;
+    mPool.run((mView.height - cy % 2 + 1) / 2, [&](size_t row, unsigned) {
+        const int y = cy % 2 + 2 * static_cast<int>(row);
+        const int *source = outer.row(cy + (y - cy) / 2);
+        int *target = iterations.row(y);
+        for (int x = x0; x < mView.width; x += 2) {
+            target[x] = source[cx + (x - cx) / 2];
+        }
+    });
+    mScratch[0].stats.cachedPixels += static_cast<long long>((mView.width - x0 + 1) / 2) * ((mView.height - cy % 2 + 1) / 2);
+}
+
+static long long floorDivide(long long a, long long b)
+{
+    return a / b - (a % b < 0);
+}
+
+void CpuRenderer::setupLattice(const View &view)
+{
+    const double spacingRe = view.planeWidth / view.width;
+    const double spacingIm = view.planeHeight / view.height;
+    // the lattice index of the top left pixel, far out in the plane it wouldn't fit
+    const auto topLeft = view.pixelToPlane(0, 0);
+    const double i0 = std::round(topLeft.real() / spacingRe);
+    const double j0 = std::round(-topLeft.imag() / spacingIm);
+    mLattice = (mOptions.tileCacheBytes > 0 || mTileStore.isOpen()) && !mOptions.distance && !mOptions.centeredGrid && !mOptions.logPolar && mPrecision == Precision::Double
+        && std::abs(i0) < 0x1p52 && std::abs(j0) < 0x1p52;
+    if (!mLattice) {
+        return;
+    }
+    mLatticeSpacingRe = spacingRe;
+    mLatticeSpacingIm = spacingIm;
+    mLatticeX = floorDivide(static_cast<long long>(i0), tileSize) * tileSize;
+    mLatticeY = floorDivide(static_cast<long long>(j0), tileSize) * tileSize;
+    mCrop.x0 = static_cast<int>(static_cast<long long>(i0) - mLatticeX);
+    mCrop.y0 = static_cast<int>(static_cast<long long>(j0) - mLatticeY);
+    mCrop.x1 = mCrop.x0 + view.width - 1;
+    mCrop.y1 = mCrop.y0 + view.height - 1;
+    mView.width = (mCrop.x1 / tileSize + 1) * tileSize;
+    mView.height = (mCrop.y1 / tileSize + 1) * tileSize;
+    mView.planeWidth = mView.width * spacingRe;
+    mView.planeHeight = mView.height * spacingIm;
+}
+
+bool CpuRenderer::renderPass(IterationBuffer &iterations, const std::atomic<bool> *cancel)
+{
+    IterationBuffer &frame = mLattice ? mLatticeFrame : iterations;
+    if (!runPass(frame, cancel)) {
+        return false;
+    }
+    if (mLattice) {
+        iterations.resize(mCrop.x1 - mCrop.x0 + 1, mCrop.y1 - mCrop.y0 + 1);
+        mPool.run(iterations.height, [&](size_t y, unsigned) {
+            const int *source = frame.row(mCrop.y0 + static_cast<int>(y)) + mCrop.x0;
+            std::copy(source, source + iterations.width, iterations.row(static_cast<int>(y)));
+        });
+    }
+    auto collectStats = [this]() {
+        mStats = {};
+        for (auto &scratch : mScratch) {
+            mStats += scratch.stats;
+        }
+    };
+    if (mPassStep > 1) {
+        collectStats();
+        mPassStep /= 2;
+        return true;
+    }
+    storeTiles(frame);
+    mSupersamples.clear();
+    if (mOptions.antialias > 0 && !mPolar && !antialias(frame, cancel)) {
+        return false;
+    }
+    collectStats();
+
+    if (mOptions.verify) {
+        // nothing skipped, on the requested view's own grid: neither snapped to the axis nor to the lattice
+        Options bruteForce;
+        bruteForce.subdivide = bruteForce.cardioid = bruteForce.periodicity = bruteForce.derivative = bruteForce.symmetry = false;
+        bruteForce.passStep = 1;
+        bruteForce.tileCacheBytes = 0;
+        const View latticeView = mView;
+        const bool lattice = mLattice;
+        mSeeded = false;
+        mLattice = false;
+        mView = mRequestedView;
+        setupCoordinates(mView, mPrecision, false);
+        setupFrame(bruteForce, mVerifyBuffer);
+        runPass(mVerifyBuffer, nullptr);
+        mLattice = lattice;
+        mView = latticeView;
+        setupCoordinates(mView, mPrecision, mOptions.snapAxis);
+        for (int y = 0; y < iterations.height; ++y) {
+            for (int x = 0; x < iterations.width; ++x) {
+                mStats.mismatchedPixels += iterations.at(x, y) != mVerifyBuffer.at(x, y);
+            }
+        }
+    }
+    return false;
+}
+
+void CpuRenderer::Supersamples::clear()
+{
+    pixel.clear();
+    first.clear();
+    counts.clear();
+}
+
+bool CpuRenderer::antialias(const IterationBuffer &frame, const std::atomic<bool> *cancel)
+{
+    const Rectangle crop = mLattice ? mCrop : Rectangle { 0, 0, mView.width - 1, mView.height - 1 };
+    const int rows = 16;
+    mSampleBlocks.resize((crop.y1 - crop.y0) / rows + 1);
+    mPool.run(mSampleBlocks.size(), [&](size_t b, unsigned worker) {
+        mSampleBlocks[b].clear();
+        if (cancel && cancel->load(std::memory_order_relaxed)) {
+            return;
+        }
+        const int y0 = crop.y0 + static_cast<int>(b) * rows;
+        antialiasBlock(frame, crop, { crop.x0, y0, crop.x1, std::min(crop.y1, y0 + rows - 1) }, mSampleBlocks[b], mScratch[worker]);
+    });
+    if (cancel && cancel->load()) {
+        return false;
+    }
+
+    for (const auto &block : mSampleBlocks) {
+        const int base = static_cast<int>(mSupersamples.counts.size());
+        mSupersamples.pixel.insert(mSupersamples.pixel.end(), block.pixel.begin(), block.pixel.end());
+        for (int first : block.first) {
+            mSupersamples.first.push_back(base + first);
+        }
+        mSupersamples.counts.insert(mSupersamples.counts.end(), block.counts.begin(), block.counts.end());
+    }
+    mSupersamples.first.push_back(static_cast<int>(mSupersamples.counts.size()));
+    return true;
+}
+
+static uint64_t mixBits(uint64_t v)
+{
+    v = (v ^ (v >> 30)) * 0xbf58476d1ce4e5b9;
+    v = (v ^ (v >> 27)) * 0x94d049bb133111eb;
+    return v ^ (v >> 31);
+}
+
+// samples.first gets no end marker, antialias() adds it after merging the blocks
+void CpuRenderer::antialiasBlock(const IterationBuffer &frame, const Rectangle &crop, const Rectangle &block, Supersamples &samples, Scratch &scratch) const
+{
+    const View &view = mView;
+    const int threshold = mOptions.antialiasThreshold;
+    auto differs = [&](int a, int b) { return std::abs(a - b) > threshold || (a == view.maxIterations) != (b == view.maxIterations); };
+    // with distance estimates (never on the lattice), an edge pixel whose lower bound d / 4 exceeds the spacing has no
+    // point of the set within a pixel of it and is left as it is
+    const double *distances = mFrameOptions.distance ? mDistances.data() : nullptr;
+    const double spacing = view.pixelSpacing();
+    scratch.edges.clear();
+    for (int y = block.y0; y <= block.y1; ++y) {
+        for (int x = block.x0; x <= block.x1; ++x) {
+            const int c = frame.at(x, y);
+            if ((x > crop.x0 && differs(c, frame.at(x - 1, y))) || (x < crop.x1 && differs(c, frame.at(x + 1, y))) || (y > crop.y0 && differs(c, frame.at(x, y - 1)))
+                || (y < crop.y1 && differs(c, frame.at(x, y + 1)))) {
+                if (distances && distances[static_cast<size_t>(y) * view.width + x] / 4 > spacing) {
+                    ++scratch.stats.distantPixels;
+                    continue;
+                }
+                scratch.edges.push_back(x);
+                scratch.edges.push_back(y);
+            }
+        }
+    }
+    const int pixels = static_cast<int>(scratch.edges.size() / 2);
+    if (!pixels) {
+        return;
+    }
+
+    // The sample points of a pixel follow the R2 sequence (generalized golden ratio) shifted by a random amount
+    // seeded by the pixel's position, so any prefix of it covers the pixel evenly and a pixel always gets the same
+    // points; on the lattice they even survive panning.
+    const double spacingRe = mLattice ? mLatticeSpacingRe : view.planeWidth / view.width;
+    const double spacingIm = mLattice ? mLatticeSpacingIm : view.planeHeight / view.height;
+    const long long originX = mLattice ? mLatticeX : 0;
+    const long long originY = mLattice ? mLatticeY : 0;
+    auto queue = [&](int k, int from, int to) {
+        const int x = scratch.edges[2 * k];
+        const int y = scratch.edges[2 * k + 1];
+        const uint64_t seed = mixBits(static_cast<uint64_t>(originX + x) * 0x9e3779b97f4a7c15 ^ static_cast<uint64_t>(originY + y));
+        const double u0 = (seed >> 11) * 0x1p-53;
+        const double v0 = (mixBits(seed) >> 11) * 0x1p-53;
+        for (int s = from; s < to; ++s) {
+            double u = u0 + s * 0.7548776662466927;
+            double v = v0 + s * 0.5698402909980532;
+            scratch.x.push_back(x);
+            scratch.y.push_back(y);
+            scratch.offsetRe.push_back((u - std::floor(u) - 0.5) * spacingRe);
+            scratch.offsetIm.push_back(-(v - std::floor(v) - 0.5) * spacingIm);
+        }
+    };
+    auto compute = [&]() {
+        const int count = static_cast<int>(scratch.x.size());
+        scratch.results.resize(count);
+        computePixels(view, mPrecision, scratch.results.data(), scratch);
+        // computePixels counted them as pixels
+        scratch.stats.computedPixels -= count;
+        scratch.stats.antialiasSamples += count;
+        scratch.x.clear();
+        scratch.y.clear();
+        scratch.offsetRe.clear();
+        scratch.offsetIm.clear();
+    };
+
+    const int first = std::min(4, mOptions.antialias);
+    scratch.x.clear();
+    scratch.y.clear();
+    scratch.offsetRe.clear();
+    scratch.offsetIm.clear();
+    for (int k = 0; k < pixels; ++k) {
+        queue(k, 0, first);
+    }
+    compute();
+    scratch.firstSamples.swap(scratch.results);
+    scratch.refine.clear();
+    for (int k = 0; k < pixels; ++k) {
+        const int c = frame.at(scratch.edges[2 * k], scratch.edges[2 * k + 1]);
+        const int *r = scratch.firstSamples.data() + k * first;
+        if (std::any_of(r, r + first, [&](int v) { return differs(c, v); })) {
+            scratch.refine.push_back(k);
+            queue(k, first, mOptions.antialias);
+        }
+    }
+    if (!scratch.refine.empty()) {
+        compute();
+    }
+
+    const int width = crop.x1 - crop.x0 + 1;
+    const int rest = mOptions.antialias - first;
+    size_t refined = 0;
+    for (int k = 0; k < pixels; ++k) {
+        samples.pixel.push_back((scratch.edges[2 * k + 1] - crop.y0) * width + scratch.edges[2 * k] - crop.x0);
+        samples.first.push_back(static_cast<int>(samples.counts.size()));
+        const int *r = scratch.firstSamples.data() + k * first;
+        samples.counts.insert(samples.counts.end(), r, r + first);
+        if (refined < scratch.refine.size() && scratch.refine[refined] == k) {
+            r = scratch.results.data() + refined * rest;
+            samples.counts.insert(samples.counts.end(), r, r + rest);
+            ++refined;
+        }
+    }
+    scratch.stats.antialiasedPixels += pixels;
+}
+
+TileCache::Key CpuRenderer::getTileKey(const Rectangle &tile) const
+{
+    return { mLatticeSpacingRe, mLatticeSpacingIm, (mLatticeX + tile.x0) / tileSize, (mLatticeY + tile.y0) / tileSize, mView.maxIterations, mView.type,
+        mView.juliaConst };
+}
+
+// the options that may change a count, tiles in the store are only shared between runs with the same ones
+TileStore::Variant CpuRenderer::getTileVariant() const
+{
+    const Options &o = mOptions;
+    return o.subdivide | o.cardioid << 1 | o.periodicity << 2 | o.derivative << 3 | o.symmetry << 4 | o.guess << 5 | (o.passStep > 1) << 6;
+}
+
+void CpuRenderer::storeTiles(const IterationBuffer &frame)
+{
+    const bool store = !mFrameOptions.tileStore.empty() && mTileStore.isOpen();
+    for (const auto &tile : mNewTiles) {
+        std::vector<int> counts(tileSize * tileSize);
+        for (int y = 0; y < tileSize; ++y) {
+            const int *row = frame.row(tile.y0 + y) + tile.x0;
+            std::copy(row, row + tileSize, counts.begin() + y * tileSize);
+        }
+        const auto key = getTileKey(tile);
+        if (store) {
+            mTileStore.insert(key, getTileVariant(), counts.data());
+        }
+        if (mFrameOptions.tileCacheBytes > 0) {
+            mTileCache.insert(key, std::move(counts));
+        }
+    }
+    mNewTiles.clear();
+    if (!mTileStore.flush()) {
+        fprintf(stderr, "Can't lock tile store %s, not using it anymore: %s\n", mFrameOptions.tileStore.c_str(),
+                strerror(errno));
+    }
+}
+
+// Grid position of the axis (coordinate 0) along one side of the view, times two so that it lands on either a pixel
+// center or a pixel edge, -1 if the mirror image of no pixel is inside the view. base is the coordinate of the view
+// center, pixel i of the side is at base + direction * (i + 0.5 - size / 2) * spacing (rows count downwards).
+static int getMirrorAxis2(double base, double spacing, int size, double direction)
+{
+    double axis = size / 2.0 - 0.5 - base / (direction * spacing);
+    if (!(axis > -0.5 && axis < size - 1)) {
+        return -1;
+    }
+    return static_cast<int>(std::lround(2.0 * axis));
+}
+
+void CpuRenderer::setupCoordinates(const View &view, Precision precision, bool snapAxis)
+{
+    // the offsets from the center are small enough for doubles, only the sum may need more precision
+    DoubleDouble baseRe { view.centerRe.toDouble(), 0.0 };
+    DoubleDouble baseIm { view.centerIm.toDouble(), 0.0 };
+    bool absolute = true;
+    if (precision == Precision::DoubleDouble) {
+        baseRe = toDoubleDouble(view.centerRe);
+        baseIm = toDoubleDouble(view.centerIm);
+    } else if (precision == Precision::Perturbation) {
+        baseRe = { mReferenceOffset.real(), 0.0 };
+        baseIm = { mReferenceOffset.imag(), 0.0 };
+        // offsets are only symmetric around a reference on the axis
+        absolute = mReference.centerIm.isZero();
+    }
+
+    mColumnRe.resize(view.width);
+    mColumnReLo.resize(view.width);
+    mRowIm.resize(view.height);
+    mRowImLo.resize(view.height);
+    auto setCoordinate = [&](double &hi, double &lo, DoubleDouble base, double offset) {
+        if (precision == Precision::DoubleDouble) {
+            DoubleDouble v = base + offset;
+            hi = v.hi;
+            lo = v.lo;
+        } else {
+            hi = base.hi + offset;
+            lo = 0.0;
+        }
+    };
+    const bool julia = view.type == ShaderType::Julia;
+    mHasMirror = false;
+    mPolar = mOptions.logPolar;
+    if (mPolar) {
+        // every pixel starts at the center, computePixels() adds the polar offset
+        mColumnRe.assign(view.width, baseRe.hi);
+        mColumnReLo.assign(view.width, baseRe.lo);
+        mRowIm.assign(view.height, baseIm.hi);
+        mRowImLo.assign(view.height, baseIm.lo);
+        const double angle = 2 * M_PI / view.width;
+        mCos.resize(view.width);
+        mSin.resize(view.width);
+        for (int x = 0; x < view.width; ++x) {
+            mCos[x] = std::cos(angle * (x + 0.5));
+            mSin[x] = std::sin(angle * (x + 0.5));
+        }
+        mRadius.resize(view.height);
+        for (int y = 0; y < view.height; ++y) {
+            mRadius[y] = view.planeWidth / 2 * std::exp(-angle * (y + 0.5));
+        }
+        return;
+    }
+    if (mOptions.centeredGrid) {
+        const double spacingRe = view.planeWidth / view.width;
+        const double spacingIm = view.planeHeight / view.height;
+        for (int x = 0; x < view.width; ++x) {
+            setCoordinate(mColumnRe[x], mColumnReLo[x], baseRe, (x - view.width / 2) * spacingRe);
+        }
+        for (int y = 0; y < view.height; ++y) {
+            setCoordinate(mRowIm[y], mRowImLo[y], baseIm, (view.height / 2 - y) * spacingIm);
+        }
+        return;
+    }
+    if (mLattice) {
+        // lattice pixel i is at i * spacing, exactly the negation of pixel -i, so the axes are lattice lines
+        for (int x = 0; x < view.width; ++x) {
+            mColumnRe[x] = static_cast<double>(mLatticeX + x) * mLatticeSpacingRe;
+            mColumnReLo[x] = 0.0;
+        }
+        for (int y = 0; y < view.height; ++y) {
+            mRowIm[y] = static_cast<double>(-(mLatticeY + y)) * mLatticeSpacingIm;
+            mRowImLo[y] = 0.0;
+        }
+        if (!mOptions.symmetry) {
+            return;
+        }
+        auto getLatticeAxis2 = [](long long origin, int size) { return -origin >= 0 && -origin < size - 1 ? static_cast<int>(-2 * origin) : -1; };
+        mMirrorY2 = getLatticeAxis2(mLatticeY, view.height);
+        mMirrorX2 = julia ? getLatticeAxis2(mLatticeX, view.width) : 0;
+        if (mMirrorY2 < 0 || mMirrorX2 < 0) {
+            return;
+        }
+    } else {
+        for (int x = 0; x < view.width; ++x) {
+            setCoordinate(mColumnRe[x], mColumnReLo[x], baseRe, view.pixelOffset(x, 0).real());
+        }
+        for (int y = 0; y < view.height; ++y) {
+            setCoordinate(mRowIm[y], mRowImLo[y], baseIm, view.pixelOffset(0, y).imag());
+        }
+        if (!mOptions.symmetry || !snapAxis || !absolute) {
+            return;
+        }
+        const double spacingRe = view.planeWidth / view.width;
+        const double spacingIm = view.planeHeight / view.height;
+        mMirrorY2 = getMirrorAxis2(baseIm.hi, spacingIm, view.height, -1.0);
+        mMirrorX2 = julia ? getMirrorAxis2(baseRe.hi, spacingRe, view.width, 1.0) : 0;
+        if (mMirrorY2 < 0 || mMirrorX2 < 0) {
+            return;
+        }
+
+        // on the snapped grid a pixel is an integer number of half spacings from the axis, which is exactly symmetric
+        // (the product's error is its own mirror image too); the low part keeps the product exact for double-double
+        auto setSnapped = [&](double &hi, double &lo, int halfSteps, double spacing) {
+            hi = halfSteps * (spacing / 2);
+            lo = precision == Precision::DoubleDouble ? std::fma(halfSteps, spacing / 2, -hi) : 0.0;
+        };
+        for (int y = 0; y < view.height; ++y) {
+            setSnapped(mRowIm[y], mRowImLo[y], mMirrorY2 - 2 * y, spacingIm);
+        }
+        if (julia) {
+            for (int x = 0; x < view.width; ++x) {
+                setSnapped(mColumnRe[x], mColumnReLo[x], 2 * x - mMirrorX2, spacingRe);
+            }
+        }
+    }
+
+    // the rows below the axis whose mirror image is in the view, computed is everything else
+    mMirrored.y0 = mMirrorY2 / 2 + 1;
+    mMirrored.y1 = std::min(view.height - 1, mMirrorY2);
+    mMirrored.x0 = julia ? std::max(0, mMirrorX2 - (view.width - 1)) : 0;
+    mMirrored.x1 = julia ? std::min(view.width - 1, mMirrorX2) : view.width - 1;
+    mHasMirror = mMirrored.y0 <= mMirrored.y1 && mMirrored.x0 <= mMirrored.x1;
+}
+
+void CpuRenderer::setupFrame(const Options &options, IterationBuffer &iterations)
+{
+    const View &view = mView;
+    mFrameOptions = options;
+    // a power of two, so that every pass halves the blocks of the one before
+    mFrameOptions.passStep = 1;
+    while (mFrameOptions.passStep <= options.passStep / 2) {
+        mFrameOptions.passStep *= 2;
+    }
+    mPassStep = mFrameOptions.passStep;
+    iterations.resize(view.width, view.height);
+    // only the double kernels estimate distances
+    mFrameOptions.distance = options.distance && mPrecision == Precision::Double;
+    if (mFrameOptions.distance) {
+        mDistances.assign(static_cast<size_t>(view.width) * view.height, 0.0);
+    }
+    for (auto &scratch : mScratch) {
+        scratch.stats = {};
+    }
+
+    // the cost per pixel varies by orders of magnitude (interior vs exterior), so the frame is cut into many tiles
+    // and the pool balances them by stealing; tiles are cut around the mirrored pixels
+    mMirrorFrame = options.symmetry && mHasMirror;
+    mTiles.clear();
+    mNewTiles.clear();
+    const bool cache = mLattice && options.tileCacheBytes > 0;
+    const bool store = mLattice && !options.tileStore.empty() && mTileStore.isOpen();
+    if (store) {
+        mTileStore.refresh();
+    }
+    for (int y0 = 0; y0 < view.height; y0 += tileSize) {
+        for (int x0 = 0; x0 < view.width; x0 += tileSize) {
+            Rectangle tile { x0, y0, std::min(x0 + tileSize, view.width) - 1, std::min(y0 + tileSize, view.height) - 1 };
+            if (cache || store) {
+                // on the lattice every tile is whole
+                const auto key = getTileKey(tile);
+                const int *counts = cache ? mTileCache.find(key) : nullptr;
+                if (!counts && store) {
+                    counts = mTileStore.find(key, getTileVariant());
+                }
+                if (counts) {
+                    for (int y = 0; y < tileSize; ++y) {
+                        std::copy(counts + y * tileSize, counts + (y + 1) * tileSize, iterations.row(y0 + y) + x0);
+                    }
+                    // the mirror image is copied over the cached pixels as well and counts them
+                    const Rectangle &m = mMirrored;
+                    const long long mirrored = mMirrorFrame ? static_cast<long long>(std::max(0, std::min(tile.x1, m.x1) - std::max(tile.x0, m.x0) + 1))
+                            * std::max(0, std::min(tile.y1, m.y1) - std::max(tile.y0, m.y0) + 1)
+                                                            : 0;
+                    mScratch[0].stats.cachedPixels += tileSize * tileSize - mirrored;
+                    continue;
+                }
+                mNewTiles.push_back(tile);
+            }
+            const Rectangle &m = mMirrored;
+            if (!mMirrorFrame || tile.x1 < m.x0 || tile.x0 > m.x1 || tile.y1 < m.y0 || tile.y0 > m.y1) {
+                mTiles.push_back(tile);
+                continue;
+            }
+            // above, below, left and right of the mirrored pixels
+            const int top = std::max(tile.y0, m.y0);
+            const int bottom = std::min(tile.y1, m.y1);
+            for (const Rectangle &piece : { Rectangle { tile.x0, tile.y0, tile.x1, m.y0 - 1 }, Rectangle { tile.x0, m.y1 + 1, tile.x1, tile.y1 },
+                     Rectangle { tile.x0, top, m.x0 - 1, bottom }, Rectangle { m.x1 + 1, top, tile.x1, bottom } }) {
+                if (piece.x0 <= piece.x1 && piece.y0 <= piece.y1) {
+                    mTiles.push_back(piece);
+                }
+            }
+        }
+    }
+}
+
+bool CpuRenderer::runPass(IterationBuffer &iterations, const std::atomic<bool> *cancel)
+{
+    const View &view = mView;
+    const bool progressive = mFrameOptions.passStep > 1;
+    const bool subdivide = mPassStep == 1 && mFrameOptions.subdivide && !mFrameOptions.guess;
+    mPool.run(mTiles.size(), [&](size_t tile, unsigned worker) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) {
+            return;
+        }
+        auto &scratch = mScratch[worker];
+        scratch.known = progressive && subdivide ? &mTiles[tile] : nullptr;
+        scratch.distances = mFrameOptions.distance ? mDistances.data() : nullptr;
+        if (!progressive || subdivide) {
+            renderTile(view, mPrecision, iterations, mTiles[tile], scratch);
+        } else {
+            renderTilePass(view, mPrecision, iterations, mTiles[tile], mPassStep, scratch);
+        }
+    });
+    if (cancel && cancel->load()) {
+        return false;
+    }
+
+    if (mMirrorFrame) {
+        const Rectangle &m = mMirrored;
+        const bool julia = view.type == ShaderType::Julia;
+        mPool.run(m.y1 - m.y0 + 1, [&](size_t row, unsigned worker) {
+            const int y = m.y0 + static_cast<int>(row);
+            const int *source = iterations.row(mMirrorY2 - y);
+            int *target = iterations.row(y);
+            if (julia) {
+                for (int x = m.x0; x <= m.x1; ++x) {
+                    target[x] = source[mMirrorX2 - x];
+                }
+            } else {
+                std::copy(source + m.x0, source + m.x1 + 1, target + m.x0);
+            }
+            if (mFrameOptions.distance) {
+                const double *sourceDistance = mDistances.data() + static_cast<size_t>(mMirrorY2 - y) * view.width;
+                double *targetDistance = mDistances.data() + static_cast<size_t>(y) * view.width;
+                for (int x = m.x0; x <= m.x1; ++x) {
+                    targetDistance[x] = sourceDistance[julia ? mMirrorX2 - x : x];
+                }
+            }
+            if (mPassStep == 1) {
+                mScratch[worker].stats.mirroredPixels += m.x1 - m.x0 + 1;
+            }
+        });
+    }
+    return true;
+}
+
+void CpuRenderer::updateReference(const View &view)
+{
+    // with the real axis in view the reference goes onto it, its orbit is then real and the pixel offsets symmetric
+    const bool onAxis = mOptions.symmetry && std::abs(view.centerIm.toDouble()) <= view.planeHeight / 2;
+
+    // the reference can stay while it is near the view (panning) and precise enough, pixels only need their offset to it
+    if (mReference.isValid() && mReference.maxIterations == view.maxIterations && mReference.centerRe.fractionLimbs() >= view.centerRe.fractionLimbs()
+        && (!onAxis || mReference.centerIm.isZero())) {
+        std::complex<double> offset((view.centerRe - mReference.centerRe).toDouble(), (view.centerIm - mReference.centerIm).toDouble());
+        if (std::abs(offset.real()) <= view.planeWidth && std::abs(offset.imag()) <= view.planeHeight) {
+            mReferenceOffset = offset;
+            updateSeries(view);
+            return;
+        }
+    }
+    if (onAxis) {
+        mReference.compute(view.centerRe, FixedPoint(0.0, view.centerIm.fractionLimbs()), view.maxIterations);
+        mReferenceOffset = { 0.0, view.centerIm.toDouble() };
+    } else {
+        mReference.compute(view.centerRe, view.centerIm, view.maxIterations);
+        mReferenceOffset = 0.0;
+    }
+    mSeries.radius = 0.0;
+    mBla.clear();
+    updateSeries(view);
+}
+
+void CpuRenderer::updateSeries(const View &view)
+{
+    // the series has to hold for the pixel farthest from the reference, one of the corners
+    double radius = std::abs(mReferenceOffset) + std::abs(std::complex<double>(view.planeWidth, view.planeHeight)) / 2;
+    const double spacing = getSpacing(view);
+    if (radius != mSeries.radius || spacing != mSeries.pixelSpacing) {
+        mSeries.compute(mReference, radius, spacing);
+    }
+    // the table is kept for the same reference as long as the view fits, with some room for zooming out
+    if (!mBla.isValidFor(mReference, radius)) {
+        mBla.build(mReference, 2 * radius, mPool);
+    }
+}
+
+void CpuRenderer::renderTile(const View &view, Precision precision, IterationBuffer &iterations, const Rectangle &tile, Scratch &scratch) const
+{
+    const int x0 = tile.x0;
+    const int y0 = tile.y0;
+    const int w = tile.x1 - tile.x0 + 1;
+    const int h = tile.y1 - tile.y0 + 1;
+
+    if (!mFrameOptions.subdivide && mSeeded) {
+        for (int y = y0; y < y0 + h; ++y) {
+            scratch.x.resize(w);
+            scratch.y.assign(w, y);
+            for (int x = 0; x < w; ++x) {
+                scratch.x[x] = x0 + x;
+            }
+            computeQueued(view, precision, iterations, scratch);
+        }
+        return;
+    }
+    if (!mFrameOptions.subdivide) {
+        scratch.x.resize(w);
+        scratch.y.resize(w);
+        for (int x = 0; x < w; ++x) {
+            scratch.x[x] = x0 + x;
+        }
+        for (int y = y0; y < y0 + h; ++y) {
+            std::fill(scratch.y.begin(), scratch.y.end(), y);
+            computePixels(view, precision, iterations.row(y) + x0, scratch);
+            if (scratch.distances) {
+                std::copy(scratch.estimates.begin(), scratch.estimates.end(), scratch.distances + static_cast<size_t>(y) * view.width + x0);
+            }
+        }
+        return;
+    }
+
+    // the border of the whole tile first, from then on every rectangle has a known border
+    const int x1 = x0 + w - 1;
+    const int y1 = y0 + h - 1;
+    scratch.x.clear();
+    scratch.y.clear();
+    for (int x = x0; x <= x1; ++x) {
+        scratch.x.push_back(x);
+        scratch.y.push_back(y0);
+        if (y1 != y0) {
+            scratch.x.push_back(x);
+            scratch.y.push_back(y1);
+        }
+    }
+    for (int y = y0 + 1; y < y1; ++y) {
+        scratch.x.push_back(x0);
+        scratch.y.push_back(y);
+        if (x1 != x0) {
+            scratch.x.push_back(x1);
+            scratch.y.push_back(y);
+        }
+    }
+    computeQueued(view, precision, iterations, scratch);
+    subdivide(view, precision, iterations, x0, y0, x1, y1, scratch);
+}
+
+// One progressive pass over a tile. The grid of a pass is every step-th column and row from the corner of the tile
+// plus its last ones, so it contains the grid of the pass before; the first pass computes all of it, later ones the
+// points the finer step added, with solid guessing only in the blocks of the previous pass whose corners differ.
+// Until the last pass every block of the grid is then filled with its top left pixel.
+void CpuRenderer::renderTilePass(const View &view, Precision precision, IterationBuffer &iterations, const Rectangle &tile, int step, Scratch &scratch) const
+{
+    auto setGrid = [step](int from, int to, std::vector<int> &grid) {
+        grid.clear();
+        for (int v = from; v < to; v += step) {
+            grid.push_back(v);
+        }
+        grid.push_back(to);
+    };
+    setGrid(tile.x0, tile.x1, scratch.columns);
+    setGrid(tile.y0, tile.y1, scratch.rows);
+
+    scratch.x.clear();
+    scratch.y.clear();
+    if (step == mFrameOptions.passStep) {
+        for (int y : scratch.rows) {
+            for (int x : scratch.columns) {
+                scratch.x.push_back(x);
+                scratch.y.push_back(y);
+            }
+        }
+    } else {
+        // a block of the previous pass owns the new points inside and on its top and left edge, the last ones also
+        // those on their right and bottom edge; a guessed point already has the value of the block from the preview
+        const int coarse = 2 * step;
+        for (int ya = tile.y0;; ya += coarse) {
+            const int yb = std::min(ya + coarse, tile.y1);
+            const int ym = ya + step < yb ? ya + step : -1;
+            for (int xa = tile.x0;; xa += coarse) {
+                const int xb = std::min(xa + coarse, tile.x1);
+                const int xm = xa + step < xb ? xa + step : -1;
+                const int corner = iterations.at(xa, ya);
+                const bool uniform = mFrameOptions.guess && iterations.at(xb, ya) == corner && iterations.at(xa, yb) == corner
+                    && iterations.at(xb, yb) == corner;
+                auto add = [&](int x, int y) {
+                    if (x < 0 || y < 0) {
+                        return;
+                    }
+                    if (uniform) {
+                        ++scratch.stats.filledPixels;
+                    } else {
+                        scratch.x.push_back(x);
+                        scratch.y.push_back(y);
+                    }
+                };
+                add(xm, ya);
+                add(xa, ym);
+                add(xm, ym);
+                if (xb == tile.x1 && xb != xa) {
+                    add(xb, ym);
+                }
+                if (yb == tile.y1 && yb != ya) {
+                    add(xm, yb);
+                }
+                if (xb == tile.x1) {
+                    break;
+                }
+            }
+            if (yb == tile.y1) {
+                break;
+            }
+        }
+    }
+    computeQueued(view, precision, iterations, scratch);
+
+    if (step == 1) {
+        return;
+    }
+    const auto &columns = scratch.columns;
+    const auto &rows = scratch.rows;
+    for (size_t j = 0; j < rows.size(); ++j) {
+        const int y1 = j + 1 < rows.size() ? rows[j + 1] - 1 : tile.y1;
+        for (size_t i = 0; i < columns.size(); ++i) {
+            const int x1 = i + 1 < columns.size() ? columns[i + 1] - 1 : tile.x1;
+            const int value = iterations.at(columns[i], rows[j]);
+            for (int y = rows[j]; y <= y1; ++y) {
+                std::fill(iterations.row(y) + columns[i], iterations.row(y) + x1 + 1, value);
+            }
+            if (scratch.distances) {
+                // a guessed point keeps this one as well
+                double *row = scratch.distances + static_cast<size_t>(rows[j]) * view.width;
+                const double distance = row[columns[i]];
+                for (int y = rows[j]; y <= y1; ++y, row += view.width) {
+                    std::fill(row + columns[i], row + x1 + 1, distance);
+                }
+            }
+        }
+    }
+}
+
+// Rectangles are processed a generation at a time so the kernels get the dividing lines of all of them in one batch
+// (long batches keep every SIMD lane busy). Their border is always computed already.
+void CpuRenderer::subdivide(const View &view, Precision precision, IterationBuffer &iterations, int x0, int y0, int x1, int y1, Scratch &scratch) const
+{
+    const double spacing = view.pixelSpacing();
+    // the probes of an interior rectangle: the ring just inside its border and every interiorProbeStep-th pixel
+    auto forEachProbe = [](const Rectangle &r, auto &&f) {
+        for (int y = r.y0 + 1; y < r.y1; ++y) {
+            const bool ring = y == r.y0 + 1 || y == r.y1 - 1;
+            const bool gridRow = (y - r.y0) % interiorProbeStep == 0;
+            for (int x = r.x0 + 1; x < r.x1; ++x) {
+                if (ring || x == r.x0 + 1 || x == r.x1 - 1 || (gridRow && (x - r.x0) % interiorProbeStep == 0)) {
+                    f(x, y);
+                }
+            }
+        }
+    };
+    auto fill = [&](const Rectangle &r, int value, double nearest) {
+        for (int y = r.y0 + 1; y < r.y1; ++y) {
+            std::fill(iterations.row(y) + r.x0 + 1, iterations.row(y) + r.x1, value);
+            if (scratch.distances) {
+                // d / 4 of the result is the guaranteed distance
+                double *row = scratch.distances + static_cast<size_t>(y) * view.width;
+                std::fill(row + r.x0 + 1, row + r.x1, std::max(0.0, nearest - 2 * spacing));
+            }
+        }
+        scratch.stats.filledPixels += static_cast<long long>(r.x1 - r.x0 - 1) * (r.y1 - r.y0 - 1);
+    };
+    // split the longer side, the dividing line becomes the shared border of both halves
+    auto split = [&](const Rectangle &r) {
+        if (r.x1 - r.x0 >= r.y1 - r.y0) {
+            const int xm = (r.x0 + r.x1) / 2;
+            for (int y = r.y0 + 1; y < r.y1; ++y) {
+                scratch.x.push_back(xm);
+                scratch.y.push_back(y);
+            }
+            scratch.split.push_back({ r.x0, r.y0, xm, r.y1 });
+            scratch.split.push_back({ xm, r.y0, r.x1, r.y1 });
+        } else {
+            const int ym = (r.y0 + r.y1) / 2;
+            for (int x = r.x0 + 1; x < r.x1; ++x) {
+                scratch.x.push_back(x);
+                scratch.y.push_back(ym);
+            }
+            scratch.split.push_back({ r.x0, r.y0, r.x1, ym });
+            scratch.split.push_back({ r.x0, ym, r.x1, r.y1 });
+        }
+    };
+
+    scratch.rectangles.assign(1, { x0, y0, x1, y1 });
+    scratch.divide.clear();
+    while (!scratch.rectangles.empty() || !scratch.divide.empty()) {
+        scratch.x.clear();
+        scratch.y.clear();
+        scratch.split.clear();
+        scratch.probed.clear();
+        for (const auto &r : scratch.divide) {
+            split(r);
+        }
+        scratch.divide.clear();
+        for (const auto &r : scratch.rectangles) {
+            if (r.x1 - r.x0 < 2 || r.y1 - r.y0 < 2) {
+                continue;
+            }
+
+            const int value = iterations.at(r.x0, r.y0);
+            bool uniform = true;
+            for (int x = r.x0; x <= r.x1 && uniform; ++x) {
+                uniform = iterations.at(x, r.y0) == value && iterations.at(x, r.y1) == value;
+            }
+            for (int y = r.y0 + 1; y < r.y1 && uniform; ++y) {
+                uniform = iterations.at(r.x0, y) == value && iterations.at(r.x1, y) == value;
+            }
+            // A filament of the set could slip between two pixels of an exterior border. With distance estimates the
+            // border has to keep it out: every point of the border is within half a spacing of a pixel, so when the
+            // lower bound d / 4 of every border pixel exceeds the spacing, the set is more than half a spacing away
+            // from all of the rectangle.
+            double nearest = 0.0;
+            if (uniform && scratch.distances && value != view.maxIterations) {
+                const double *d = scratch.distances;
+                const size_t width = view.width;
+                nearest = std::numeric_limits<double>::infinity();
+                for (int x = r.x0; x <= r.x1; ++x) {
+                    nearest = std::min({ nearest, d[r.y0 * width + x], d[r.y1 * width + x] });
+                }
+                for (int y = r.y0 + 1; y < r.y1; ++y) {
+                    nearest = std::min({ nearest, d[y * width + r.x0], d[y * width + r.x1] });
+                }
+                uniform = nearest / 4 > spacing;
+            }
+            const int area = (r.x1 - r.x0 - 1) * (r.y1 - r.y0 - 1);
+            // The exterior is connected too, and a channel of it can just as well pass between the pixels of an interior
+            // border. Such channels mostly end within a pixel or two of the border and near the boundary, so only
+            // large interior rectangles are filled, and only once their probes are interior as well; the others are
+            // split.
+            if (uniform && value == view.maxIterations) {
+                if (std::min(r.x1 - r.x0, r.y1 - r.y0) > interiorMinimumSide) {
+                    forEachProbe(r, [&](int x, int y) {
+                        scratch.x.push_back(x);
+                        scratch.y.push_back(y);
+                    });
+                    scratch.probed.push_back(r);
+                    continue;
+                }
+                uniform = false;
+            }
+            if (uniform) {
+                fill(r, value, nearest);
+                continue;
+            }
+
+            if (area <= subdivideMinimumArea) {
+                for (int y = r.y0 + 1; y < r.y1; ++y) {
+                    for (int x = r.x0 + 1; x < r.x1; ++x) {
+                        scratch.x.push_back(x);
+                        scratch.y.push_back(y);
+                    }
+                }
+                continue;
+            }
+            split(r);
+        }
+        computeQueued(view, precision, iterations, scratch);
+        for (const auto &r : scratch.probed) {
+            bool interior = true;
+            forEachProbe(r, [&](int x, int y) { interior = interior && iterations.at(x, y) == view.maxIterations; });
+            if (interior) {
+                fill(r, view.maxIterations, 0.0);
+            } else {
+                scratch.divide.push_back(r);
+            }
+        }
+        std::swap(scratch.rectangles, scratch.split);
+    }
+}
+
+void CpuRenderer::computeQueued(const View &view, Precision precision, IterationBuffer &iterations, Scratch &scratch) const
+{
+    if (scratch.known || mSeeded) {
+        // the last progressive pass only adds the pixels between those of the pass before (step 2), a seeded frame
+        // those between the ones it copied
+        const Rectangle &k = scratch.known ? *scratch.known : Rectangle { -1, -1, -1, -1 };
+        size_t kept = 0;
+        for (size_t i = 0; i < scratch.x.size(); ++i) {
+            const int x = scratch.x[i];
+            const int y = scratch.y[i];
+            if ((!scratch.known || ((x - k.x0) % 2 && x != k.x1) || ((y - k.y0) % 2 && y != k.y1)) && !isSeeded(x, y)) {
+                scratch.x[kept] = x;
+                scratch.y[kept] = y;
+                ++kept;
+            }
+        }
+        scratch.x.resize(kept);
+        scratch.y.resize(kept);
+    }
+    const int count = static_cast<int>(scratch.x.size());
+    scratch.results.resize(count);
+    computePixels(view, precision, scratch.results.data(), scratch);
+    for (int i = 0; i < count; ++i) {
+        iterations.at(scratch.x[i], scratch.y[i]) = scratch.results[i];
+    }
+    if (scratch.distances) {
+        for (int i = 0; i < count; ++i) {
+            scratch.distances[static_cast<size_t>(scratch.y[i]) * view.width + scratch.x[i]] = scratch.estimates[i];
+        }
+    }
+}
+
+void CpuRenderer::computePixels(const View &view, Precision precision, int *results, Scratch &scratch) const
+{
+    const int count = static_cast<int>(scratch.x.size());
+    // the samples of anti-aliasing need no estimate
+    const bool estimate = scratch.distances && scratch.offsetRe.empty();
+    const double *offsetRe = scratch.offsetRe.empty() ? nullptr : scratch.offsetRe.data();
+    const double *offsetIm = scratch.offsetIm.empty() ? nullptr : scratch.offsetIm.data();
+    if (mPolar) {
+        scratch.polarRe.resize(count);
+        scratch.polarIm.resize(count);
+        for (int i = 0; i < count; ++i) {
+            scratch.polarRe[i] = mRadius[scratch.y[i]] * mCos[scratch.x[i]];
+            scratch.polarIm[i] = mRadius[scratch.y[i]] * mSin[scratch.x[i]];
+        }
+        offsetRe = scratch.polarRe.data();
+        offsetIm = scratch.polarIm.data();
+    }
+    const bool offsets = offsetRe != nullptr;
+    if (estimate) {
+        scratch.estimates.assign(count, 0.0);
+    }
+    scratch.stats.computedPixels += count;
+    scratch.pixelRe.resize(count);
+    scratch.pixelIm.resize(count);
+
+    // mandelbrot: z0 = 0, c = pixel; julia: z0 = pixel, c = constant
+    const bool julia = view.type == ShaderType::Julia;
+    if (precision != Precision::Perturbation) {
+        scratch.fixedRe.assign(count, julia ? view.juliaConst.real() : 0.0);
+        scratch.fixedIm.assign(count, julia ? view.juliaConst.imag() : 0.0);
+    }
+
+    switch (precision) {
+    case Precision::Double: {
+        // points caught by the cardioid test never reach the kernel
+        const bool cardioid = !julia && mFrameOptions.cardioid;
+        scratch.index.resize(count);
+        int n = 0;
+        for (int i = 0; i < count; ++i) {
+            const double re = mColumnRe[scratch.x[i]] + (offsets ? offsetRe[i] : 0.0);
+            const double im = mRowIm[scratch.y[i]] + (offsets ? offsetIm[i] : 0.0);
+            if (cardioid && isInCardioidOrBulb(re, im)) {
+                results[i] = view.maxIterations;
+                ++scratch.stats.cardioidPixels;
+                continue;
+            }
+            scratch.pixelRe[n] = re;
+            scratch.pixelIm[n] = im;
+            scratch.index[n++] = i;
+        }
+        EscapeBatch batch { scratch.pixelRe.data(), scratch.pixelIm.data(), scratch.fixedRe.data(), scratch.fixedIm.data(), n };
+        if (!julia) {
+            batch = { scratch.fixedRe.data(), scratch.fixedIm.data(), scratch.pixelRe.data(), scratch.pixelIm.data(), n };
+        }
+        InteriorChecks checks;
+        checks.periodicity = mFrameOptions.periodicity;
+        checks.derivative = mFrameOptions.derivative;
+        checks.scaleTo(getSpacing(view));
+        DistanceEstimate distance;
+        if (estimate) {
+            scratch.kernelEstimates.resize(n);
+            distance.distance = scratch.kernelEstimates.data();
+            distance.julia = julia;
+        }
+        InteriorStats interior;
+        scratch.kernelResults.resize(n);
+        mKernel(batch, view.maxIterations, checks, distance, scratch.kernelResults.data(), interior);
+        for (int k = 0; k < n; ++k) {
+            results[scratch.index[k]] = scratch.kernelResults[k];
+        }
+        if (estimate) {
+            for (int k = 0; k < n; ++k) {
+                scratch.estimates[scratch.index[k]] = scratch.kernelEstimates[k];
+            }
+        }
+        scratch.stats.periodicPixels += interior.periodic;
+        scratch.stats.attractingPixels += interior.attracting;
+        break;
+    }
+    case Precision::DoubleDouble: {
+        scratch.pixelReLo.resize(count);
+        scratch.pixelImLo.resize(count);
+        scratch.fixedReLo.assign(count, 0.0);
+        scratch.fixedImLo.assign(count, 0.0);
+        for (int i = 0; i < count; ++i) {
+            DoubleDouble re { mColumnRe[scratch.x[i]], mColumnReLo[scratch.x[i]] };
+            DoubleDouble im { mRowIm[scratch.y[i]], mRowImLo[scratch.y[i]] };
+            if (offsets) {
+                re = re + offsetRe[i];
+                im = im + offsetIm[i];
+            }
+            scratch.pixelRe[i] = re.hi;
+            scratch.pixelReLo[i] = re.lo;
+            scratch.pixelIm[i] = im.hi;
+            scratch.pixelImLo[i] = im.lo;
+        }
+        const double *pixel[] = { scratch.pixelRe.data(), scratch.pixelReLo.data(), scratch.pixelIm.data(), scratch.pixelImLo.data() };
+        const double *fixed[] = { scratch.fixedRe.data(), scratch.fixedReLo.data(), scratch.fixedIm.data(), scratch.fixedImLo.data() };
+        DoubleDoubleBatch batch { pixel[0], pixel[1], pixel[2], pixel[3], fixed[0], fixed[1], fixed[2], fixed[3], count };
+        if (!julia) {
+            batch = { fixed[0], fixed[1], fixed[2], fixed[3], pixel[0], pixel[1], pixel[2], pixel[3], count };
+        }
+        mDoubleDoubleKernel(batch, view.maxIterations, results);
+        break;
+    }
+    case Precision::Perturbation:
+        for (int i = 0; i < count; ++i) {
+            scratch.pixelRe[i] = mColumnRe[scratch.x[i]] + (offsets ? offsetRe[i] : 0.0);
+            scratch.pixelIm[i] = mRowIm[scratch.y[i]] + (offsets ? offsetIm[i] : 0.0);
+        }
+        escapePerturbed(mReference, &mSeries, &mBla, scratch.pixelRe.data(), scratch.pixelIm.data(), count, view.maxIterations, results);
+        break;
+    }
+}
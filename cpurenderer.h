@@ -0,0 +1,279 @@
+#pragma once
+
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include "bla.h"
+#include "doubledouble.h"
+#include "iterationbuffer.h"
+#include "kernel.h"
+#include "perturbation.h"
+#include "threadpool.h"
+#include "tilecache.h"
+#include "tilestore.h"
+#include "view.h"
+
+// Native escape-time engine, the counterpart of the fragment shaders for machines without a usable GPU
+class CpuRenderer
+{
+public:
+    // Work savers on top of the plain escape-time iteration
+    struct Options {
+        // Mariani-Silver: a rectangle whose whole border has the same iteration count is filled without computing
+        // its interior (the set and its escape-time bands are connected), the others are split and tried again
+        bool subdivide = true;
+        // analytic main cardioid and period 2 bulb test (Mandelbrot set at double precision)
+        bool cardioid = true;
+        // the interior checks of the double kernels, see InteriorChecks; with periodicity on, the derivative check
+        // catches the same points a little earlier but costs more on exterior points than it saves
+        bool periodicity = true;
+        bool derivative = false;
+        // the Mandelbrot set is symmetric about the real axis, Julia sets under z -> -z: when the view contains the
+        // axis (both axes for Julia sets) and the sampling grid is exactly symmetric, the mirror image of the computed
+        // side is copied. The tile cache lattice always is; any other grid only with snapAxis, which moves it by at
+        // most a quarter pixel and so changes the image slightly.
+        bool symmetry = true;
+        bool snapAxis = false;
+        // Progressive rendering: the first pass computes every passStep-th pixel of every passStep-th row, each further
+        // pass halves the step; until the last one the frame is a preview in which every block has the value of its
+        // top left pixel. Rounded down to a power of two, 1 renders the frame in a single pass. The default shows 1/16
+        // and 1/4 of the pixels before the full frame, the last pass subdivides the blocks between the known pixels.
+        int passStep = 4;
+        // solid guessing (Fractint): from the second pass on, a block of the previous pass whose four corners agree is
+        // filled instead of refined; needs passStep > 1 and replaces subdivide
+        bool guess = false;
+        // Byte budget of the tile cache, 0 turns it off. Frames at double precision are then sampled on the lattice
+        // of their zoom level (shifted by at most half a pixel) and rendered in whole lattice tiles, so after a pan
+        // only the newly exposed tiles are computed. verify compares against the requested view itself, so it counts
+        // the pixels that the shift changes.
+        size_t tileCacheBytes = size_t(256) << 20;
+        // file of the persistent tile store (see TileStore) behind the cache, shared between runs and processes;
+        // empty for none
+        std::string tileStore;
+        // Adaptive anti-aliasing: a pixel whose count jumps against a neighbour (by more than antialiasThreshold, or
+        // between interior and exterior) gets up to antialias extra samples at jittered points of its area, the first
+        // four for every such pixel, the rest only where those disagree with the center. 0 turns it off.
+        int antialias = 0;
+        int antialiasThreshold = 1;
+        // Exterior distance estimation at double precision (see DistanceEstimate), getDistances() then has the estimate
+        // of every pixel. Subdivision fills an exterior rectangle only when the estimates of its border keep the set
+        // out of it, anti-aliasing skips edge pixels that are provably more than a pixel away from the set. The tile
+        // cache doesn't keep estimates and is off meanwhile.
+        bool distance = false;
+        // Zoom sequences (see ZoomSequence): every pixel is sampled at a whole number of spacings from the view center,
+        // (x - width / 2, y - height / 2), which is up to half a pixel off the view. A frame with half the plane size
+        // then has every other pixel in common with this one. Turns off symmetry and the tile cache lattice.
+        bool centeredGrid = false;
+        // Exponential map strips (see ExponentialMap): column x is at the angle 2pi (x + 0.5) / width around the view
+        // center, row y at the radius planeWidth / 2 * exp(-2pi (y + 0.5) / width), so pixels are about square and
+        // every row is a constant factor further in. The precision follows the spacing of the last row. Turns off
+        // symmetry, the tile cache lattice and anti-aliasing, and takes precedence over centeredGrid.
+        bool logPolar = false;
+        // renders every frame a second time without the savers and counts the pixels that differ (slow)
+        bool verify = false;
+    };
+
+    // pixel counts of the last frame
+    struct Stats {
+        long long computedPixels = 0;
+        long long filledPixels = 0;
+        long long mirroredPixels = 0;
+        // copied from the tile cache or store, or from the frame one octave out (zoom sequences)
+        long long cachedPixels = 0;
+        // computed pixels that an interior shortcut caught
+        long long cardioidPixels = 0;
+        long long periodicPixels = 0;
+        long long attractingPixels = 0;
+        // anti-aliasing
+        long long antialiasedPixels = 0;
+        long long antialiasSamples = 0;
+        // edge pixels left out because their distance estimate keeps them away from the set
+        long long distantPixels = 0;
+        // only with Options::verify
+        long long mismatchedPixels = 0;
+
+        Stats &operator+=(const Stats &o);
+    };
+
+    // Extra samples of the anti-aliased pixels of the last finished frame: pixel[k] (y * width + x) has the counts
+    // counts[first[k]] ... counts[first[k + 1] - 1] besides its own
+    struct Supersamples {
+        std::vector<int> pixel, first, counts;
+
+        void clear();
+    };
+
+    // threads == 0 uses every available core
+    explicit CpuRenderer(unsigned threads = 0, KernelIsa isa = detectKernelIsa());
+
+    // Fills iterations with the escape-time iteration count of every pixel of the view
+    void render(const View &view, IterationBuffer &iterations);
+    // The same a pass at a time: beginFrame() sets up the view, every renderPass() leaves a complete (preview) frame
+    // in iterations and returns whether more passes follow. Starting another frame abandons the rest of this one.
+    // A pass stops at the next tile once *cancel is set, the frame is then left unfinished and false returned.
+    // With Options::centeredGrid, outer may be the finished frame of the same center and size with twice the plane
+    // size: the pixels both have in common are copied from it (in a single pass, without distance estimates).
+    void beginFrame(const View &view, IterationBuffer &iterations, const IterationBuffer *outer = nullptr);
+    bool renderPass(IterationBuffer &iterations, const std::atomic<bool> *cancel = nullptr);
+    // pixel step of the next pass
+    int passStep() const { return mPassStep; }
+    unsigned threads() const { return mPool.size(); }
+    // for work around the frames (resampling, coloring) on the same threads
+    ThreadPool &pool() { return mPool; }
+    // iterations the series approximation skipped for every pixel of the last (deep zoom) frame
+    int getSeriesSkip() const { return mSeries.skip; }
+    KernelIsa isa() const { return mIsa; }
+    void setOptions(const Options &options);
+    const Options &options() const { return mOptions; }
+    // false when Options::tileStore couldn't be opened
+    bool hasTileStore() const { return mTileStore.isOpen(); }
+    const Stats &getStats() const { return mStats; }
+    const Supersamples &getSupersamples() const { return mSupersamples; }
+    // Distance estimates of the last frame, row-major without padding; empty unless Options::distance is on and the
+    // frame was at double precision. A filled pixel gets the least distance its rectangle's border guarantees.
+    const std::vector<double> &getDistances() const { return mDistances; }
+
+    // tile edge in pixels, a whole number of cache lines of the iteration buffer
+    static constexpr int tileSize = 4 * IterationBuffer::pixelsPerCacheLine;
+    // below this pixel spacing doubles can't tell neighbouring pixels apart anymore and double-double takes over
+    static constexpr double doubleDoubleSpacing = 1e-12;
+    // the same limit for double-double, below it the Mandelbrot set is perturbed around a reference orbit (Julia
+    // sets have no reference and stay at double-double)
+    static constexpr double perturbationSpacing = 1e-28;
+    // rectangles with at most this many interior pixels are computed instead of subdivided further
+    static constexpr int subdivideMinimumArea = 16;
+    // interior rectangles are only filled when both sides are longer than this, and after the ring just inside their
+    // border and a grid of every interiorProbeStep-th pixel turned out interior as well
+    static constexpr int interiorMinimumSide = 16;
+    static constexpr int interiorProbeStep = 4;
+
+private:
+    enum class Precision { Double, DoubleDouble, Perturbation };
+
+    // inclusive pixel bounds
+    struct Rectangle {
+        int x0, y0, x1, y1;
+    };
+
+    // per worker kernel input, reused between tiles and frames
+    struct Scratch {
+        // pixel coordinates to compute
+        std::vector<int> x, y, results;
+        // kernel input index -> queue index, for the pixels left after the cardioid test
+        std::vector<int> index, kernelResults;
+        // subdivision generations; interior rectangles waiting for their probes, and those to split without another
+        // look at their border
+        std::vector<Rectangle> rectangles, split, probed, divide;
+        // progressive pass grid of the tile
+        std::vector<int> columns, rows;
+        // sub-pixel offsets of the queued points, none for the pixel centers
+        std::vector<double> offsetRe, offsetIm;
+        // offsets of the queued points from the center in log-polar frames
+        std::vector<double> polarRe, polarIm;
+        // anti-aliased pixels of the block, x and y interleaved, their first samples and those that get the rest
+        std::vector<int> edges, firstSamples, refine;
+        // the tile of a last pass that subdivides, its pixels on the grid of the pass before are known already
+        const Rectangle *known = nullptr;
+        // distance estimates of the frame, null when off; those of the queued pixels and of the kernel input
+        double *distances = nullptr;
+        std::vector<double> estimates, kernelEstimates;
+        std::vector<double> pixelRe, pixelIm, fixedRe, fixedIm;
+        // low parts for the double-double kernel
+        std::vector<double> pixelReLo, pixelImLo, fixedReLo, fixedImLo;
+        Stats stats;
+    };
+
+    void setupFrame(const Options &options, IterationBuffer &iterations);
+    bool runPass(IterationBuffer &iterations, const std::atomic<bool> *cancel);
+    void renderTile(const View &view, Precision precision, IterationBuffer &iterations, const Rectangle &tile, Scratch &scratch) const;
+    void renderTilePass(const View &view, Precision precision, IterationBuffer &iterations, const Rectangle &tile, int step, Scratch &scratch) const;
+    void subdivide(const View &view, Precision precision, IterationBuffer &iterations, int x0, int y0, int x1, int y1, Scratch &scratch) const;
+    // iteration counts of the pixels queued in scratch.x, scratch.y; computeQueued() stores them in the buffer
+    void computePixels(const View &view, Precision precision, int *results, Scratch &scratch) const;
+    void computeQueued(const View &view, Precision precision, IterationBuffer &iterations, Scratch &scratch) const;
+    void setupLattice(const View &view);
+    // finest pixel spacing of a view, the bottom row of a log-polar one
+    double getSpacing(const View &view) const;
+    Precision getPrecision(const View &view) const;
+    void setupCoordinates(const View &view, Precision precision, bool snapAxis);
+    void seedFrame(const IterationBuffer &outer, IterationBuffer &iterations);
+    bool isSeeded(int x, int y) const { return mSeeded && !((x - mView.width / 2) & 1) && !((y - mView.height / 2) & 1); }
+    bool antialias(const IterationBuffer &frame, const std::atomic<bool> *cancel);
+    void antialiasBlock(const IterationBuffer &frame, const Rectangle &crop, const Rectangle &block, Supersamples &samples, Scratch &scratch) const;
+    TileCache::Key getTileKey(const Rectangle &tile) const;
+    TileStore::Variant getTileVariant() const;
+    void storeTiles(const IterationBuffer &frame);
+    void updateReference(const View &view);
+    void updateSeries(const View &view);
+
+    ThreadPool mPool;
+    KernelIsa mIsa;
+    EscapeKernel mKernel;
+    DoubleDoubleKernel mDoubleDoubleKernel;
+    std::vector<Scratch> mScratch;
+    Options mOptions;
+    // the options of the frame being rendered, verification turns everything off
+    Options mFrameOptions;
+    // the view being rendered, on the lattice it grows to whole tiles around the requested one
+    View mView;
+    View mRequestedView;
+    Precision mPrecision = Precision::Double;
+    // step of the next pass
+    int mPassStep = 1;
+    bool mMirrorFrame = false;
+    Stats mStats;
+    Supersamples mSupersamples;
+    // per block of rows, merged into mSupersamples
+    std::vector<Supersamples> mSampleBlocks;
+    std::vector<double> mDistances;
+    IterationBuffer mVerifyBuffer;
+    // Pixel coordinates of the frame: absolute, or the offset from the reference with perturbation; the low parts
+    // are only used by double-double. A pixel is (mColumnRe[x], mRowIm[y]).
+    std::vector<double> mColumnRe, mColumnReLo, mRowIm, mRowImLo;
+    // Options::logPolar: the pixel is that plus (mRadius[y] * mCos[x], mRadius[y] * mSin[x])
+    bool mPolar = false;
+    std::vector<double> mCos, mSin, mRadius;
+    // pixels copied from their mirror image (x, y) -> (mMirrorX2 - x, mMirrorY2 - y); x stays for the Mandelbrot set
+    Rectangle mMirrored;
+    bool mHasMirror = false;
+    int mMirrorX2 = 0;
+    int mMirrorY2 = 0;
+    // the pixels on the even grid around the center came from the frame one octave out
+    bool mSeeded = false;
+    std::vector<Rectangle> mTiles;
+    TileCache mTileCache;
+    TileStore mTileStore;
+    // Lattice sampling (see TileCache): pixel (x, y) of mView is lattice pixel (mLatticeX + x, mLatticeY + y), mCrop
+    // is the requested view within it. Frames are rendered into mLatticeFrame and cropped to the caller's buffer.
+    bool mLattice = false;
+    long long mLatticeX = 0;
+    long long mLatticeY = 0;
+    double mLatticeSpacingRe = 0.0;
+    double mLatticeSpacingIm = 0.0;
+    Rectangle mCrop;
+    IterationBuffer mLatticeFrame;
+    // tiles of the frame that weren't cached, stored once it is finished
+    std::vector<Rectangle> mNewTiles;
+    ReferenceOrbit mReference;
+    SeriesApproximation mSeries;
+    BlaTable mBla;
+    // offset of the view center from the reference point
+    std::complex<double> mReferenceOffset;
+};
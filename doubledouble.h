@@ -0,0 +1,93 @@
+#pragma once
+
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+// Double-double numbers: an unevaluated sum hi + lo of two doubles with |lo| <= ulp(hi) / 2, about 106 bits of
+// mantissa at a few times the cost of a double. The operations follow Dekker / QD's "sloppy" variants, whose error
+// is relative to the operands like a double operation's, which is all the escape-time iteration needs.
+// The SIMD kernels in kernel.cpp repeat these exact operation sequences lane-wise, so keep them in sync.
+
+#include <cmath>
+
+struct DoubleDouble {
+    double hi = 0.0;
+    double lo = 0.0;
+};
+
+// hi + lo == a + b exactly, requires |a| >= |b|
+inline DoubleDouble quickTwoSum(double a, double b)
+{
+    double s = a + b;
+    return { s, b - (s - a) };
+}
+
+// hi + lo == a + b exactly
+inline DoubleDouble twoSum(double a, double b)
+{
+    double s = a + b;
+    double bb = s - a;
+    return { s, (a - (s - bb)) + (b - bb) };
+}
+
+inline DoubleDouble twoDifference(double a, double b)
+{
+    double s = a - b;
+    double bb = s - a;
+    return { s, (a - (s - bb)) - (b + bb) };
+}
+
+inline DoubleDouble operator+(DoubleDouble a, DoubleDouble b)
+{
+    DoubleDouble s = twoSum(a.hi, b.hi);
+    return quickTwoSum(s.hi, s.lo + (a.lo + b.lo));
+}
+
+inline DoubleDouble operator+(DoubleDouble a, double b)
+{
+    DoubleDouble s = twoSum(a.hi, b);
+    return quickTwoSum(s.hi, s.lo + a.lo);
+}
+
+inline DoubleDouble operator-(DoubleDouble a, DoubleDouble b)
+{
+    DoubleDouble s = twoDifference(a.hi, b.hi);
+    return quickTwoSum(s.hi, s.lo + (a.lo - b.lo));
+}
+
+// the error of the product hi * hi comes exactly from a fused multiply-subtract
+inline DoubleDouble operator*(DoubleDouble a, DoubleDouble b)
+{
+    double p = a.hi * b.hi;
+    double e = std::fma(a.hi, b.hi, -p);
+    return quickTwoSum(p, e + (a.hi * b.lo + a.lo * b.hi));
+}
+
+inline DoubleDouble square(DoubleDouble a)
+{
+    double p = a.hi * a.hi;
+    double e = std::fma(a.hi, a.hi, -p);
+    double t = a.hi * a.lo;
+    return quickTwoSum(p, e + (t + t));
+}
+
+// exact
+inline DoubleDouble twice(DoubleDouble a)
+{
+    return { a.hi + a.hi, a.lo + a.lo };
+}
@@ -0,0 +1,110 @@
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "expmap.h"
+#include <algorithm>
+#include <cmath>
+
+ExponentialMap::ExponentialMap(CpuRenderer &renderer, const View &view, int width, double outerRadius)
+    : mRenderer(renderer), mView(view), mWidth(width), mBandRows(static_cast<int>(std::ceil(width * std::log(2.0) / (2 * M_PI)))), mOuterRadius(outerRadius)
+{
+}
+
+int ExponentialMap::getWidth(const View &view)
+{
+    const double halfDiagonal = std::abs(std::complex<double>(view.planeWidth, view.planeHeight)) / 2;
+    return std::max(8, static_cast<int>(std::ceil(2 * M_PI * halfDiagonal / view.pixelSpacing())));
+}
+
+long long ExponentialMap::getRow(double radius) const
+{
+    return static_cast<long long>(std::floor(mWidth / (2 * M_PI) * std::log(mOuterRadius / radius)));
+}
+
+void ExponentialMap::require(double innerRadius, double outerRadius)
+{
+    mStats = {};
+    const long long first = std::max(0LL, getRow(outerRadius) / mBandRows);
+    const long long last = std::max(first, getRow(innerRadius) / mBandRows);
+    for (; mFirstBand < first && !mBands.empty(); ++mFirstBand) {
+        mBands.pop_front();
+    }
+    if (mBands.empty()) {
+        mFirstBand = std::max(mFirstBand, first);
+    }
+    // band b spans the radii from outerRadius * exp(-2pi b bandRows / width) one octave inwards
+    while (mFirstBand + static_cast<long long>(mBands.size()) <= last) {
+        const long long band = mFirstBand + static_cast<long long>(mBands.size());
+        View view = mView;
+        view.width = mWidth;
+        view.height = mBandRows;
+        view.planeWidth = 2 * mOuterRadius * std::exp(-2 * M_PI * static_cast<double>(band * mBandRows) / mWidth);
+        view.planeHeight = view.planeWidth;
+        mRenderer.render(view, mBands.emplace_back());
+        mStats += mRenderer.getStats();
+    }
+}
+
+void ExponentialMap::resample(const View &view, IterationBuffer &iterations)
+{
+    const double aspect = view.planeHeight / view.planeWidth;
+    // the aspect of the zoom levels differs in the last bits
+    if (view.width != mFrameWidth || view.height != mFrameHeight || !(std::abs(aspect - mAspect) <= 1e-9 * aspect)) {
+        mFrameWidth = view.width;
+        mFrameHeight = view.height;
+        mAspect = aspect;
+        mColumns.resize(static_cast<size_t>(view.width) * view.height);
+        mLogRadii.resize(mColumns.size());
+        for (int y = 0; y < view.height; ++y) {
+            for (int x = 0; x < view.width; ++x) {
+                const double re = (x + 0.5) / view.width - 0.5;
+                const double im = -((y + 0.5) / view.height - 0.5) * aspect;
+                // angles from [-pi, pi] to [0, 2pi)
+                const double turn = std::atan2(im, re) / (2 * M_PI);
+                const int column = static_cast<int>(std::floor((turn < 0.0 ? turn + 1.0 : turn) * mWidth));
+                mColumns[static_cast<size_t>(y) * view.width + x] = std::min(column, mWidth - 1);
+                mLogRadii[static_cast<size_t>(y) * view.width + x] = mWidth / (2 * M_PI) * std::log(std::hypot(re, im));
+            }
+        }
+    }
+
+    iterations.resize(view.width, view.height);
+    if (mBands.empty()) {
+        return;
+    }
+    // strip row of a pixel: floor(width / 2pi * log(outerRadius / (planeWidth * r))), r its distance at plane width 1,
+    // counted here from the first kept row
+    mRows.clear();
+    for (const auto &band : mBands) {
+        for (int y = 0; y < mBandRows; ++y) {
+            mRows.push_back(band.row(y));
+        }
+    }
+    const double offset = mWidth / (2 * M_PI) * std::log(mOuterRadius / view.planeWidth) - static_cast<double>(mFirstBand * mBandRows);
+    const int last = static_cast<int>(mRows.size()) - 1;
+    mRenderer.pool().run(view.height, [&](size_t y, unsigned) {
+        const int *columns = mColumns.data() + y * view.width;
+        const double *logRadii = mLogRadii.data() + y * view.width;
+        int *target = iterations.row(static_cast<int>(y));
+        for (int x = 0; x < view.width; ++x) {
+            // the center pixel may be closer than the last row
+            const double row = offset - logRadii[x];
+            const int n = row >= 0.0 ? static_cast<int>(std::min(row, static_cast<double>(last))) : 0;
+            target[x] = mRows[n][columns[x]];
+        }
+    });
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <deque>
+#include <vector>
+#include "cpurenderer.h"
+
+// Exponential map of a zoom: a strip of width angles around the center (columns) and radii falling by the factor
+// exp(2pi / width) from row to row (see CpuRenderer::Options::logPolar), so every pixel of the strip is about square
+// and any zoom level into the center is a band of its rows. A zoom movie then computes every depth once instead of
+// in every frame that shows it, and resample() reconstructs its frames.
+// The strip is rendered in bands of one octave of radii, each a frame of its own (with the precision, reference orbit
+// and tables of its depth), and only the bands the current frames need are kept: memory is bounded by the frame size,
+// neither by the depth of the zoom nor by the number of frames.
+class ExponentialMap
+{
+public:
+    // view supplies the center, type and iteration limit; row 0 is just inside outerRadius
+    ExponentialMap(CpuRenderer &renderer, const View &view, int width, double outerRadius);
+    ExponentialMap(const ExponentialMap &) = delete;
+    ExponentialMap &operator=(const ExponentialMap &) = delete;
+
+    // angles for a frame of the size of view whose corner pixels are as wide as the strip's there
+    static int getWidth(const View &view);
+
+    // Keeps the bands of the radii [innerRadius, outerRadius]: renders those further in that are missing and drops
+    // those further out. Zooms go inwards, a band once dropped isn't rendered again.
+    void require(double innerRadius, double outerRadius);
+    // Fills iterations with the frame of view (same center) from the required bands, every pixel from the strip pixel
+    // its center falls into; in parallel on the renderer's threads.
+    void resample(const View &view, IterationBuffer &iterations);
+    // of the bands rendered by the last require()
+    const CpuRenderer::Stats &getStats() const { return mStats; }
+
+private:
+    // strip row of a radius, rows are counted from outerRadius inwards
+    long long getRow(double radius) const;
+
+    CpuRenderer &mRenderer;
+    View mView;
+    int mWidth;
+    int mBandRows;
+    double mOuterRadius;
+    long long mFirstBand = 0;
+    std::deque<IterationBuffer> mBands;
+    CpuRenderer::Stats mStats;
+    // Geometry of the frames, the same at every zoom level: strip column of each pixel and the log of its distance to
+    // the center in rows (relative to a plane width of 1), kept while the frame size doesn't change
+    int mFrameWidth = 0;
+    int mFrameHeight = 0;
+    double mAspect = 0.0;
+    std::vector<int> mColumns;
+    std::vector<double> mLogRadii;
+    // the kept rows of the strip, for resample()
+    std::vector<const int *> mRows;
+};
@@ -0,0 +1,447 @@
+#pragma once
+
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Arbitrary precision signed fixed-point number, two's complement over 32-bit limbs (least significant first).
+// The top limb is the integer part (enough for anything the escape-time iteration produces), the others hold
+// 32 fraction bits each. Operands of a binary operation may differ in precision, the result gets the larger one.
+// Supports the same arithmetic as Mitype (double), so code written against that abstraction (see computeOrbit())
+// works with either; squareInPlace() and toDouble() are provided for both.
+// Products are computed on magnitudes into thread local scratch memory: squaring only computes the cross products
+// once, and operands of karatsubaLimbs or more are split recursively (Karatsuba, three half size products instead of
+// four).
+class FixedPoint
+{
+public:
+    using Limb = std::uint32_t;
+    static constexpr int limbBits = 32;
+    static constexpr int defaultFractionLimbs = 2;
+    static constexpr size_t karatsubaLimbs = 48;
+
+    FixedPoint(double v = 0.0, int fractionLimbs = defaultFractionLimbs)
+        : mLimbs(fractionLimbs + 1, 0)
+    {
+        setDouble(v);
+    }
+
+    // enough fraction limbs to tell apart points resolution apart, with a margin for the iteration to lose bits
+    static int getFractionLimbs(double resolution)
+    {
+        int bits = static_cast<int>(std::ceil(-std::log2(resolution))) + 2 * limbBits;
+        return std::max(defaultFractionLimbs, (bits + limbBits - 1) / limbBits);
+    }
+
+    // Decimal number such as "-0.74364388703715870475", exact to the last fraction bit (truncated beyond), so centers
+    // of deep zooms survive a command line. false if text is not one or its integer part doesn't fit the top limb.
+    static bool parse(const char *text, int fractionLimbs, FixedPoint &result)
+    {
+        const bool negative = *text == '-';
+        if (*text == '-' || *text == '+') {
+            ++text;
+        }
+        std::uint64_t integer = 0;
+        const char *digit = text;
+        for (; *digit >= '0' && *digit <= '9'; ++digit) {
+            integer = integer * 10 + (*digit - '0');
+            if (integer > 0x7fffffff) {
+                return false;
+            }
+        }
+        std::vector<Limb> decimals;
+        if (*digit == '.') {
+            for (++digit; *digit >= '0' && *digit <= '9'; ++digit) {
+                decimals.push_back(static_cast<Limb>(*digit - '0'));
+            }
+        }
+        if (*digit || digit == text || (digit == text + 1 && *text == '.')) {
+            return false;
+        }
+
+        result = FixedPoint(0.0, fractionLimbs);
+        result.mLimbs.back() = static_cast<Limb>(integer);
+        // the decimal fraction times 2^32 carries the next limb out of its integer part, most significant first
+        for (int i = fractionLimbs - 1; i >= 0; --i) {
+            std::uint64_t carry = 0;
+            for (auto d = decimals.rbegin(); d != decimals.rend(); ++d) {
+                std::uint64_t v = (static_cast<std::uint64_t>(*d) << limbBits) + carry;
+                *d = static_cast<Limb>(v % 10);
+                carry = v / 10;
+            }
+            result.mLimbs[i] = static_cast<Limb>(carry);
+        }
+        if (negative) {
+            result.negate();
+        }
+        return true;
+    }
+
+    int fractionLimbs() const { return static_cast<int>(mLimbs.size()) - 1; }
+    int fractionBits() const { return fractionLimbs() * limbBits; }
+    bool isNegative() const { return static_cast<std::int32_t>(mLimbs.back()) < 0; }
+    bool isZero() const
+    {
+        return std::all_of(mLimbs.begin(), mLimbs.end(), [](Limb l) { return l == 0; });
+    }
+
+    // extending is exact, shrinking truncates the lowest fraction limbs
+    void setFractionLimbs(int fractionLimbs)
+    {
+        int diff = fractionLimbs - this->fractionLimbs();
+        if (diff > 0) {
+            mLimbs.insert(mLimbs.begin(), diff, 0);
+        } else if (diff < 0) {
+            mLimbs.erase(mLimbs.begin(), mLimbs.begin() - diff);
+        }
+    }
+
+    double toDouble() const
+    {
+        // the magnitude of a negative number is ~x + 1, the +1 only reaches up to the lowest non-zero limb
+        const bool negative = isNegative();
+        size_t lowest = 0;
+        while (lowest < mLimbs.size() && mLimbs[lowest] == 0) {
+            ++lowest;
+        }
+        auto magnitude = [&](size_t i) -> Limb {
+            if (!negative || i < lowest) {
+                return mLimbs[i];
+            }
+            return i == lowest ? ~mLimbs[i] + 1 : ~mLimbs[i];
+        };
+        // three limbs from the most significant non-zero one are more than the 53 bits a double holds
+        double v = 0.0;
+        int used = 0;
+        for (int i = static_cast<int>(mLimbs.size()) - 1; i >= 0 && used < 3; --i) {
+            Limb limb = magnitude(i);
+            if (limb || used) {
+                v += std::ldexp(static_cast<double>(limb), (i - fractionLimbs()) * limbBits);
+                ++used;
+            }
+        }
+        return negative ? -v : v;
+    }
+    explicit operator double() const { return toDouble(); }
+
+    FixedPoint &negate()
+    {
+        std::uint64_t carry = 1;
+        for (auto &limb : mLimbs) {
+            carry += static_cast<Limb>(~limb);
+            limb = static_cast<Limb>(carry);
+            carry >>= limbBits;
+        }
+        return *this;
+    }
+
+    FixedPoint operator-() const
+    {
+        FixedPoint r(*this);
+        return r.negate();
+    }
+
+    FixedPoint &operator+=(const FixedPoint &o)
+    {
+        matchPrecision(o);
+        int shift = fractionLimbs() - o.fractionLimbs();
+        std::uint64_t carry = 0;
+        for (size_t i = 0; i < mLimbs.size(); ++i) {
+            carry += static_cast<std::uint64_t>(mLimbs[i]) + o.limbAt(static_cast<int>(i) - shift);
+            mLimbs[i] = static_cast<Limb>(carry);
+            carry >>= limbBits;
+        }
+        return *this;
+    }
+
+    FixedPoint &operator-=(const FixedPoint &o)
+    {
+        matchPrecision(o);
+        int shift = fractionLimbs() - o.fractionLimbs();
+        std::int64_t borrow = 0;
+        for (size_t i = 0; i < mLimbs.size(); ++i) {
+            std::int64_t d = static_cast<std::int64_t>(mLimbs[i]) - o.limbAt(static_cast<int>(i) - shift) + borrow;
+            mLimbs[i] = static_cast<Limb>(d);
+            borrow = d < 0 ? -1 : 0;
+        }
+        return *this;
+    }
+
+    // the product is truncated toward zero to the precision of the result
+    FixedPoint &operator*=(const FixedPoint &o)
+    {
+        if (&o == this) {
+            return squareInPlace(*this);
+        }
+        matchPrecision(o);
+        const size_t n = mLimbs.size();
+        auto &scratch = getScratch();
+        scratch.resize(4 * n + workSize(n));
+        Limb *a = scratch.data();
+        Limb *b = a + n;
+        Limb *product = b + n;
+        bool negative = loadMagnitude(a, n, fractionLimbs()) != o.loadMagnitude(b, n, fractionLimbs());
+        multiply(a, b, n, product, product + 2 * n);
+        storeProduct(product, negative);
+        return *this;
+    }
+
+    friend FixedPoint &squareInPlace(FixedPoint &v)
+    {
+        const size_t n = v.mLimbs.size();
+        auto &scratch = getScratch();
+        scratch.resize(3 * n + workSize(n));
+        Limb *a = scratch.data();
+        Limb *product = a + n;
+        v.loadMagnitude(a, n, v.fractionLimbs());
+        square(a, n, product, product + 2 * n);
+        v.storeProduct(product, false);
+        return v;
+    }
+
+    friend double toDouble(const FixedPoint &v) { return v.toDouble(); }
+
+    // doubles are converted at the precision of this number, so tiny deltas at deep zooms are kept
+    FixedPoint &operator+=(double v) { return *this += FixedPoint(v, fractionLimbs()); }
+    FixedPoint &operator-=(double v) { return *this -= FixedPoint(v, fractionLimbs()); }
+
+    friend FixedPoint operator+(FixedPoint a, const FixedPoint &b) { return a += b; }
+    friend FixedPoint operator-(FixedPoint a, const FixedPoint &b) { return a -= b; }
+    friend FixedPoint operator*(FixedPoint a, const FixedPoint &b) { return a *= b; }
+    friend FixedPoint square(FixedPoint a) { return squareInPlace(a); }
+
+    friend bool operator==(const FixedPoint &a, const FixedPoint &b)
+    {
+        return (a - b).isZero();
+    }
+    friend bool operator!=(const FixedPoint &a, const FixedPoint &b) { return !(a == b); }
+    friend bool operator<(const FixedPoint &a, const FixedPoint &b) { return (a - b).isNegative(); }
+    friend bool operator>(const FixedPoint &a, const FixedPoint &b) { return b < a; }
+
+private:
+    std::vector<Limb> mLimbs;
+
+    static std::vector<Limb> &getScratch()
+    {
+        static thread_local std::vector<Limb> scratch;
+        return scratch;
+    }
+
+    // writes the n-limb magnitude of this number at fractionLimbs precision to out, returns the sign
+    bool loadMagnitude(Limb *out, size_t n, int fractionLimbs) const
+    {
+        int shift = fractionLimbs - this->fractionLimbs();
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = limbAt(static_cast<int>(i) - shift);
+        }
+        if (!isNegative()) {
+            return false;
+        }
+        std::uint64_t carry = 1;
+        for (size_t i = 0; i < n; ++i) {
+            carry += static_cast<Limb>(~out[i]);
+            out[i] = static_cast<Limb>(carry);
+            carry >>= limbBits;
+        }
+        return true;
+    }
+
+    // takes the limbs of a 2n-limb magnitude product that line up with this number's precision
+    void storeProduct(const Limb *product, bool negative)
+    {
+        std::copy(product + fractionLimbs(), product + fractionLimbs() + mLimbs.size(), mLimbs.begin());
+        if (negative) {
+            negate();
+        }
+    }
+
+    // dst[0, n) += src[0, m), m <= n, returns the carry out of dst
+    static Limb addTo(Limb *dst, size_t n, const Limb *src, size_t m)
+    {
+        std::uint64_t carry = 0;
+        for (size_t i = 0; i < n && (i < m || carry); ++i) {
+            carry += static_cast<std::uint64_t>(dst[i]) + (i < m ? src[i] : 0);
+            dst[i] = static_cast<Limb>(carry);
+            carry >>= limbBits;
+        }
+        return static_cast<Limb>(carry);
+    }
+
+    // dst[0, n) -= src[0, m), m <= n, the result must not be negative
+    static void subtractFrom(Limb *dst, size_t n, const Limb *src, size_t m)
+    {
+        std::int64_t borrow = 0;
+        for (size_t i = 0; i < n && (i < m || borrow); ++i) {
+            std::int64_t d = static_cast<std::int64_t>(dst[i]) - (i < m ? src[i] : 0) + borrow;
+            dst[i] = static_cast<Limb>(d);
+            borrow = d < 0 ? -1 : 0;
+        }
+    }
+
+    static void multiplySchoolbook(const Limb *a, const Limb *b, size_t n, Limb *out)
+    {
+        std::fill(out, out + 2 * n, 0);
+        for (size_t i = 0; i < n; ++i) {
+            std::uint64_t carry = 0;
+            for (size_t j = 0; j < n; ++j) {
+                carry += static_cast<std::uint64_t>(a[i]) * b[j] + out[i + j];
+                out[i + j] = static_cast<Limb>(carry);
+                carry >>= limbBits;
+            }
+            out[i + n] = static_cast<Limb>(carry);
+        }
+    }
+
+    // a^2 = sum(a_i^2) + 2 * sum(a_i * a_j, i < j): about half the limb products of a general multiplication
+    static void squareSchoolbook(const Limb *a, size_t n, Limb *out)
+    {
+        std::fill(out, out + 2 * n, 0);
+        for (size_t i = 0; i < n; ++i) {
+            std::uint64_t carry = 0;
+            for (size_t j = i + 1; j < n; ++j) {
+                carry += static_cast<std::uint64_t>(a[i]) * a[j] + out[i + j];
+                out[i + j] = static_cast<Limb>(carry);
+                carry >>= limbBits;
+            }
+            out[i + n] = static_cast<Limb>(carry);
+        }
+        Limb top = 0;
+        for (size_t i = 0; i < 2 * n; ++i) {
+            Limb next = out[i] >> (limbBits - 1);
+            out[i] = (out[i] << 1) | top;
+            top = next;
+        }
+        std::uint64_t carry = 0;
+        for (size_t i = 0; i < n; ++i) {
+            std::uint64_t sq = static_cast<std::uint64_t>(a[i]) * a[i];
+            carry += static_cast<std::uint64_t>(out[2 * i]) + static_cast<Limb>(sq);
+            out[2 * i] = static_cast<Limb>(carry);
+            carry >>= limbBits;
+            carry += static_cast<std::uint64_t>(out[2 * i + 1]) + (sq >> limbBits);
+            out[2 * i + 1] = static_cast<Limb>(carry);
+            carry >>= limbBits;
+        }
+    }
+
+    // a = a1 * B^h + a0, b likewise: a * b = z2 * B^2h + (z1 - z2 - z0) * B^h + z0 with
+    // z0 = a0 * b0, z2 = a1 * b1, z1 = (a0 + a1) * (b0 + b1). Squaring is the same with b = a.
+    // z0 and z2 go straight to the two halves of out, the half sums and z1 live in work.
+    template <bool squaring>
+    static void karatsuba(const Limb *a, const Limb *b, size_t n, Limb *out, Limb *work)
+    {
+        const size_t h = n / 2;
+        const size_t k = n - h + 1; // length of the half sums, including their carry limb
+        Limb *sa = work;
+        Limb *sb = sa + k;
+        Limb *z1 = sb + k;
+        work = z1 + 2 * k;
+        std::copy(a + h, a + n, sa);
+        sa[k - 1] = addTo(sa, k - 1, a, h);
+        if (squaring) {
+            square(sa, k, z1, work);
+            square(a, h, out, work);
+            square(a + h, n - h, out + 2 * h, work);
+        } else {
+            std::copy(b + h, b + n, sb);
+            sb[k - 1] = addTo(sb, k - 1, b, h);
+            multiply(sa, sb, k, z1, work);
+            multiply(a, b, h, out, work);
+            multiply(a + h, b + h, n - h, out + 2 * h, work);
+        }
+        subtractFrom(z1, 2 * k, out, 2 * h);
+        subtractFrom(z1, 2 * k, out + 2 * h, 2 * (n - h));
+        addTo(out + h, 2 * n - h, z1, std::min(2 * k, 2 * n - h));
+    }
+
+    // scratch limbs needed by multiply() and square() of n limbs
+    static size_t workSize(size_t n)
+    {
+        const size_t k = n - n / 2 + 1;
+        return n < karatsubaLimbs ? 0 : 4 * k + workSize(k);
+    }
+
+    static void multiply(const Limb *a, const Limb *b, size_t n, Limb *out, Limb *work)
+    {
+        if (n < karatsubaLimbs) {
+            multiplySchoolbook(a, b, n, out);
+        } else {
+            karatsuba<false>(a, b, n, out, work);
+        }
+    }
+
+    static void square(const Limb *a, size_t n, Limb *out, Limb *work)
+    {
+        if (n < karatsubaLimbs) {
+            squareSchoolbook(a, n, out);
+        } else {
+            karatsuba<true>(a, a, n, out, work);
+        }
+    }
+
+    // sign-extending view of the limbs, i may point below or above the stored ones
+    Limb limbAt(int i) const
+    {
+        if (i < 0) {
+            return 0;
+        }
+        if (i >= static_cast<int>(mLimbs.size())) {
+            return isNegative() ? ~Limb(0) : 0;
+        }
+        return mLimbs[i];
+    }
+
+    void matchPrecision(const FixedPoint &o)
+    {
+        if (o.fractionLimbs() > fractionLimbs()) {
+            setFractionLimbs(o.fractionLimbs());
+        }
+    }
+
+    void setDouble(double v)
+    {
+        std::fill(mLimbs.begin(), mLimbs.end(), 0);
+        int exponent;
+        double mantissa = std::frexp(std::fabs(v), &exponent);
+        // |v| = m * 2^(exponent - 53) with m a 53-bit integer, spread it over the limbs
+        auto m = static_cast<std::uint64_t>(std::ldexp(mantissa, 53));
+        int shift = exponent - 53 + fractionBits();
+        for (int bit = 0; bit < 53; ++bit) {
+            int pos = shift + bit;
+            if ((m >> bit & 1) && pos >= 0 && pos < static_cast<int>(mLimbs.size()) * limbBits) {
+                mLimbs[pos / limbBits] |= Limb(1) << (pos % limbBits);
+            }
+        }
+        if (v < 0) {
+            negate();
+        }
+    }
+};
+
+inline double &squareInPlace(double &v)
+{
+    return v *= v;
+}
+
+inline double toDouble(double v)
+{
+    return v;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+constexpr size_t cacheLineSize = 64;
+
+template <typename T>
+struct CacheAlignedAllocator {
+    using value_type = T;
+
+    CacheAlignedAllocator() = default;
+    template <typename U>
+    CacheAlignedAllocator(const CacheAlignedAllocator<U> &) { }
+
+    T *allocate(size_t n) { return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(cacheLineSize))); }
+    void deallocate(T *p, size_t) { ::operator delete(p, std::align_val_t(cacheLineSize)); }
+
+    friend bool operator==(const CacheAlignedAllocator &, const CacheAlignedAllocator &) { return true; }
+    friend bool operator!=(const CacheAlignedAllocator &, const CacheAlignedAllocator &) { return false; }
+};
+
+// Row-major iteration counts. Every row starts on a cache line boundary (stride is padded to whole cache lines),
+// so tiles whose x offsets are multiples of pixelsPerCacheLine never write to the same line.
+struct IterationBuffer {
+    static constexpr int pixelsPerCacheLine = cacheLineSize / sizeof(int);
+
+    int width = 0;
+    int height = 0;
+    int stride = 0;
+    std::vector<int, CacheAlignedAllocator<int>> data;
+
+    void resize(int w, int h)
+    {
+        width = w;
+        height = h;
+        stride = (w + pixelsPerCacheLine - 1) / pixelsPerCacheLine * pixelsPerCacheLine;
+        data.resize(static_cast<size_t>(stride) * h);
+    }
+
+    int *row(int y) { return data.data() + static_cast<size_t>(y) * stride; }
+    const int *row(int y) const { return data.data() + static_cast<size_t>(y) * stride; }
+    int &at(int x, int y) { return row(y)[x]; }
+    int at(int x, int y) const { return row(y)[x]; }
+};
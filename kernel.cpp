@@ -0,0 +1,732 @@
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// NOTE: this file must be compiled with -ffp-contract=off (see CMakeLists.txt), a fused multiply-add in one
+// kernel but not in the other would make the iteration counts differ between instruction sets
+
+#include "kernel.h"
+#include <cmath>
+#include <limits>
+#include "doubledouble.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define KERNEL_X86 1
+#else
+#define KERNEL_X86 0
+#endif
+
+// d of a point that escaped at z with derivative (er, ei), see DistanceEstimate; k is 1 for dz/dc, 0 for dz/dz0.
+// All kernels finish their points here, so the estimate is the same for every instruction set.
+static double estimateDistance(double x, double y, double cr, double ci, double er, double ei, double k)
+{
+    for (int n = 0; n < 64; ++n) {
+        double x2 = x * x;
+        double y2 = y * y;
+        if (!(x2 + y2 < DistanceEstimate::escapeRadius2)) {
+            break;
+        }
+        double nr = x * er - y * ei;
+        ei = x * ei + y * er;
+        ei = ei + ei;
+        er = (nr + nr) + k;
+        double xy = x * y;
+        x = (x2 - y2) + cr;
+        y = (xy + xy) + ci;
+    }
+    double mag = std::sqrt(x * x + y * y);
+    double d = 2.0 * mag * std::log(mag) / std::sqrt(er * er + ei * ei);
+    // overflow far outside the set
+    return d >= 0.0 ? d : std::numeric_limits<double>::infinity();
+}
+
+// same stop condition as the shaders: maxIterations reached or |z| > 2.0
+// The interior checks are template parameters so that a disabled check costs nothing in the loop. Both look at z and
+// dz/dz0 before the step, in the same order in every kernel: the periodic point is saved after the test on the same
+// iteration, so a match needs at least one full step in between.
+// With distance on, the derivative for the estimate is updated after the checks, from the same z as the step.
+template <bool periodicity, bool derivative, bool distance>
+static void escapeScalar(const EscapeBatch &batch, int maxIterations, const InteriorChecks &checks, const DistanceEstimate &estimate, int *iterations,
+    InteriorStats &stats)
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double periodicityEpsilon = checks.periodicityEpsilon;
+    const double derivativeEpsilon2 = checks.derivativeEpsilon * checks.derivativeEpsilon;
+    const double k = estimate.julia ? 0.0 : 1.0;
+    for (int p = 0; p < batch.count; ++p) {
+        double x = batch.zRe[p];
+        double y = batch.zIm[p];
+        const double cr = batch.cRe[p];
+        const double ci = batch.cIm[p];
+        double sx = nan;
+        double sy = nan;
+        long long check = 1;
+        double dr = 1.0;
+        double di = 0.0;
+        double er = 1.0 - k;
+        double ei = 0.0;
+        int i = 0;
+        for (i = 0; i < maxIterations; ++i) {
+            double x2 = x * x;
+            double y2 = y * y;
+            if (!(x2 + y2 <= 4.0)) {
+                break;
+            }
+            if (periodicity) {
+                if (std::fabs(x - sx) < periodicityEpsilon && std::fabs(y - sy) < periodicityEpsilon) {
+                    i = maxIterations;
+                    ++stats.periodic;
+                    break;
+                }
+                if (i == check) {
+                    sx = x;
+                    sy = y;
+                    check += check;
+                }
+            }
+            if (derivative) {
+                if (dr * dr + di * di < derivativeEpsilon2) {
+                    i = maxIterations;
+                    ++stats.attracting;
+                    break;
+                }
+                // dz' = 2 * z * dz, from z_1 on: the Mandelbrot set starts at the critical point z_0 = 0
+                if (i > 0) {
+                    double nr = x * dr - y * di;
+                    di = x * di + y * dr;
+                    di = di + di;
+                    dr = nr + nr;
+                }
+            }
+            if (distance) {
+                // dz/dc' = 2 * z * dz/dc + 1 (from dz/dc = 0), dz/dz0' = 2 * z * dz/dz0 (from 1)
+                double nr = x * er - y * ei;
+                ei = x * ei + y * er;
+                ei = ei + ei;
+                er = (nr + nr) + k;
+            }
+            double xy = x * y;
+            x = (x2 - y2) + cr;
+            y = (xy + xy) + ci;
+        }
+        iterations[p] = i;
+        if (distance) {
+            estimate.distance[p] = i < maxIterations ? estimateDistance(x, y, cr, ci, er, ei, k) : 0.0;
+        }
+    }
+}
+
+static void escapeScalarDoubleDouble(const DoubleDoubleBatch &batch, int maxIterations, int *iterations)
+{
+    for (int p = 0; p < batch.count; ++p) {
+        DoubleDouble x { batch.zRe[p], batch.zReLo[p] };
+        DoubleDouble y { batch.zIm[p], batch.zImLo[p] };
+        const DoubleDouble cr { batch.cRe[p], batch.cReLo[p] };
+        const DoubleDouble ci { batch.cIm[p], batch.cImLo[p] };
+        int i = 0;
+        for (i = 0; i < maxIterations; ++i) {
+            DoubleDouble x2 = square(x);
+            DoubleDouble y2 = square(y);
+            if (!(x2.hi + y2.hi <= 4.0)) {
+                break;
+            }
+            DoubleDouble xy = x * y;
+            x = (x2 - y2) + cr;
+            y = twice(xy) + ci;
+        }
+        iterations[p] = i;
+    }
+}
+
+#if KERNEL_X86
+
+// Per-lane bookkeeping of the SIMD kernels. A lane that finishes (escaped or hit maxIterations) stores its result
+// and is immediately refilled with the next pending point, so lanes don't idle while their neighbours near the
+// boundary keep iterating. Once the batch is exhausted the lane parks on z = c = 0 with a counter that never
+// reaches maxIterations.
+// v holds the per point inputs (the arrays of the batch, in the same order), which the kernels keep in registers.
+template <int lanes, int values>
+struct LaneState {
+    alignas(64) double v[values][lanes];
+    alignas(64) long long it[lanes];
+    int index[lanes];
+    int next = 0;
+    int active = 0;
+    const double *const *inputs;
+    int count;
+
+    static constexpr long long parked = std::numeric_limits<long long>::min() / 2;
+
+    LaneState(const double *const *inputs, int count) : inputs(inputs), count(count)
+    {
+        for (int lane = 0; lane < lanes; ++lane) {
+            fill(lane);
+        }
+    }
+
+    void fill(int lane)
+    {
+        if (next < count) {
+            for (int k = 0; k < values; ++k) {
+                v[k][lane] = inputs[k][next];
+            }
+            it[lane] = 0;
+            index[lane] = next++;
+            ++active;
+        } else {
+            for (int k = 0; k < values; ++k) {
+                v[k][lane] = 0.0;
+            }
+            it[lane] = parked;
+            index[lane] = -1;
+        }
+    }
+
+    // distance estimates of the lanes about to finish, before they are refilled; v holds their last z and c
+    void estimate(unsigned doneMask, const double *er, const double *ei, double k, int maxIterations, double *distance) const
+    {
+        for (int lane = 0; lane < lanes; ++lane) {
+            if (doneMask & (1u << lane)) {
+                distance[index[lane]] = it[lane] < maxIterations ? estimateDistance(v[0][lane], v[1][lane], v[2][lane], v[3][lane], er[lane], ei[lane], k) : 0.0;
+            }
+        }
+    }
+
+    void finish(unsigned doneMask, int *iterations)
+    {
+        for (int lane = 0; lane < lanes; ++lane) {
+            if (doneMask & (1u << lane)) {
+                iterations[index[lane]] = static_cast<int>(it[lane]);
+                --active;
+                fill(lane);
+            }
+        }
+    }
+};
+
+template <bool periodicity, bool derivative, bool distance>
+__attribute__((target("avx2"))) static void escapeAvx2(const EscapeBatch &batch, int maxIterations, const InteriorChecks &checks, const DistanceEstimate &estimate,
+    int *iterations, InteriorStats &stats)
+{
+    const double *inputs[] = { batch.zRe, batch.zIm, batch.cRe, batch.cIm };
+    LaneState<4, 4> s(inputs, batch.count);
+    const __m256d four = _mm256_set1_pd(4.0);
+    const __m256i vmax = _mm256_set1_epi64x(maxIterations);
+    const __m256i one = _mm256_set1_epi64x(1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256d absMask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+    const __m256d periodicityEpsilon = _mm256_set1_pd(checks.periodicityEpsilon);
+    const __m256d derivativeEpsilon2 = _mm256_set1_pd(checks.derivativeEpsilon * checks.derivativeEpsilon);
+    const __m256d nan = _mm256_set1_pd(std::numeric_limits<double>::quiet_NaN());
+    const __m256d dOne = _mm256_set1_pd(1.0);
+    const __m256d dZero = _mm256_setzero_pd();
+    const double k = estimate.julia ? 0.0 : 1.0;
+    const __m256d dk = _mm256_set1_pd(k);
+    const __m256d eStart = _mm256_set1_pd(1.0 - k);
+    __m256d x = _mm256_load_pd(s.v[0]);
+    __m256d y = _mm256_load_pd(s.v[1]);
+    __m256d cr = _mm256_load_pd(s.v[2]);
+    __m256d ci = _mm256_load_pd(s.v[3]);
+    __m256i it = _mm256_load_si256(reinterpret_cast<const __m256i *>(s.it));
+    // interior check state, reset for the lanes that start a new point (it == 0); parked lanes are left out
+    __m256d sx = nan, sy = nan, dr = dOne, di = dZero, er = eStart, ei = dZero;
+    __m256i check = one;
+    unsigned live = ~_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(zero, it))) & 0xf;
+
+    while (s.active > 0) {
+        __m256d x2 = _mm256_mul_pd(x, x);
+        __m256d y2 = _mm256_mul_pd(y, y);
+        // NLE_UQ is !(|z|^2 <= 4), the exact negation of the scalar loop condition (including NaN)
+        __m256d escaped = _mm256_cmp_pd(_mm256_add_pd(x2, y2), four, _CMP_NLE_UQ);
+        __m256d limit = _mm256_castsi256_pd(_mm256_cmpeq_epi64(it, vmax));
+        unsigned done = _mm256_movemask_pd(_mm256_or_pd(escaped, limit));
+        unsigned interior = 0;
+        if (periodicity) {
+            __m256d nearRe = _mm256_cmp_pd(_mm256_and_pd(_mm256_sub_pd(x, sx), absMask), periodicityEpsilon, _CMP_LT_OQ);
+            __m256d nearIm = _mm256_cmp_pd(_mm256_and_pd(_mm256_sub_pd(y, sy), absMask), periodicityEpsilon, _CMP_LT_OQ);
+            unsigned periodic = _mm256_movemask_pd(_mm256_and_pd(nearRe, nearIm)) & live & ~done;
+            stats.periodic += __builtin_popcount(periodic);
+            interior |= periodic;
+        }
+        if (derivative) {
+            __m256d norm = _mm256_add_pd(_mm256_mul_pd(dr, dr), _mm256_mul_pd(di, di));
+            unsigned attracting = _mm256_movemask_pd(_mm256_cmp_pd(norm, derivativeEpsilon2, _CMP_LT_OQ)) & live & ~done & ~interior;
+            stats.attracting += __builtin_popcount(attracting);
+            interior |= attracting;
+        }
+        if (done | interior) {
+            if (interior) {
+                // lanes 0-3 of the mask to full 64-bit lanes
+                __m256i bits = _mm256_set_epi64x(8, 4, 2, 1);
+                __m256i mask = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(interior), bits), bits);
+                it = _mm256_blendv_epi8(it, vmax, mask);
+            }
+            _mm256_store_pd(s.v[0], x);
+            _mm256_store_pd(s.v[1], y);
+            _mm256_store_pd(s.v[2], cr);
+            _mm256_store_pd(s.v[3], ci);
+            _mm256_store_si256(reinterpret_cast<__m256i *>(s.it), it);
+            if (distance) {
+                alignas(32) double eRe[4], eIm[4];
+                _mm256_store_pd(eRe, er);
+                _mm256_store_pd(eIm, ei);
+                s.estimate(done | interior, eRe, eIm, k, maxIterations, estimate.distance);
+            }
+            s.finish(done | interior, iterations);
+            x = _mm256_load_pd(s.v[0]);
+            y = _mm256_load_pd(s.v[1]);
+            cr = _mm256_load_pd(s.v[2]);
+            ci = _mm256_load_pd(s.v[3]);
+            it = _mm256_load_si256(reinterpret_cast<const __m256i *>(s.it));
+            if (periodicity || derivative) {
+                live = ~_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(zero, it))) & 0xf;
+                __m256d fresh = _mm256_castsi256_pd(_mm256_cmpeq_epi64(it, zero));
+                sx = _mm256_blendv_pd(sx, nan, fresh);
+                sy = _mm256_blendv_pd(sy, nan, fresh);
+                check = _mm256_blendv_epi8(check, one, _mm256_castpd_si256(fresh));
+                dr = _mm256_blendv_pd(dr, dOne, fresh);
+                di = _mm256_blendv_pd(di, dZero, fresh);
+            }
+            if (distance) {
+                __m256d fresh = _mm256_castsi256_pd(_mm256_cmpeq_epi64(it, zero));
+                er = _mm256_blendv_pd(er, eStart, fresh);
+                ei = _mm256_blendv_pd(ei, dZero, fresh);
+            }
+            continue;
+        }
+        if (periodicity) {
+            __m256d save = _mm256_castsi256_pd(_mm256_cmpeq_epi64(it, check));
+            sx = _mm256_blendv_pd(sx, x, save);
+            sy = _mm256_blendv_pd(sy, y, save);
+            check = _mm256_blendv_epi8(check, _mm256_add_epi64(check, check), _mm256_castpd_si256(save));
+        }
+        if (derivative) {
+            // dz' = 2 * z * dz, from z_1 on
+            __m256d first = _mm256_castsi256_pd(_mm256_cmpeq_epi64(it, zero));
+            __m256d nr = _mm256_sub_pd(_mm256_mul_pd(x, dr), _mm256_mul_pd(y, di));
+            __m256d ni = _mm256_add_pd(_mm256_mul_pd(x, di), _mm256_mul_pd(y, dr));
+            dr = _mm256_blendv_pd(_mm256_add_pd(nr, nr), dr, first);
+            di = _mm256_blendv_pd(_mm256_add_pd(ni, ni), di, first);
+        }
+        if (distance) {
+            __m256d nr = _mm256_sub_pd(_mm256_mul_pd(x, er), _mm256_mul_pd(y, ei));
+            __m256d ni = _mm256_add_pd(_mm256_mul_pd(x, ei), _mm256_mul_pd(y, er));
+            er = _mm256_add_pd(_mm256_add_pd(nr, nr), dk);
+            ei = _mm256_add_pd(ni, ni);
+        }
+        __m256d xy = _mm256_mul_pd(x, y);
+        x = _mm256_add_pd(_mm256_sub_pd(x2, y2), cr);
+        y = _mm256_add_pd(_mm256_add_pd(xy, xy), ci);
+        it = _mm256_add_epi64(it, one);
+    }
+}
+
+template <bool periodicity, bool derivative, bool distance>
+__attribute__((target("avx512f"))) static void escapeAvx512(const EscapeBatch &batch, int maxIterations, const InteriorChecks &checks, const DistanceEstimate &estimate,
+    int *iterations, InteriorStats &stats)
+{
+    const double *inputs[] = { batch.zRe, batch.zIm, batch.cRe, batch.cIm };
+    LaneState<8, 4> s(inputs, batch.count);
+    const __m512d four = _mm512_set1_pd(4.0);
+    const __m512i vmax = _mm512_set1_epi64(maxIterations);
+    const __m512i one = _mm512_set1_epi64(1);
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512d periodicityEpsilon = _mm512_set1_pd(checks.periodicityEpsilon);
+    const __m512d derivativeEpsilon2 = _mm512_set1_pd(checks.derivativeEpsilon * checks.derivativeEpsilon);
+    const __m512d nan = _mm512_set1_pd(std::numeric_limits<double>::quiet_NaN());
+    const __m512d dOne = _mm512_set1_pd(1.0);
+    const __m512d dZero = _mm512_setzero_pd();
+    const double k = estimate.julia ? 0.0 : 1.0;
+    const __m512d dk = _mm512_set1_pd(k);
+    const __m512d eStart = _mm512_set1_pd(1.0 - k);
+    __m512d x = _mm512_load_pd(s.v[0]);
+    __m512d y = _mm512_load_pd(s.v[1]);
+    __m512d cr = _mm512_load_pd(s.v[2]);
+    __m512d ci = _mm512_load_pd(s.v[3]);
+    __m512i it = _mm512_load_si512(s.it);
+    __m512d sx = nan, sy = nan, dr = dOne, di = dZero, er = eStart, ei = dZero;
+    __m512i check = one;
+    unsigned live = _mm512_cmpge_epi64_mask(it, zero);
+
+    while (s.active > 0) {
+        __m512d x2 = _mm512_mul_pd(x, x);
+        __m512d y2 = _mm512_mul_pd(y, y);
+        __mmask8 escaped = _mm512_cmp_pd_mask(_mm512_add_pd(x2, y2), four, _CMP_NLE_UQ);
+        __mmask8 limit = _mm512_cmpeq_epi64_mask(it, vmax);
+        unsigned done = escaped | limit;
+        unsigned interior = 0;
+        if (periodicity) {
+            __mmask8 nearRe = _mm512_cmp_pd_mask(_mm512_abs_pd(_mm512_sub_pd(x, sx)), periodicityEpsilon, _CMP_LT_OQ);
+            __mmask8 nearIm = _mm512_cmp_pd_mask(_mm512_abs_pd(_mm512_sub_pd(y, sy)), periodicityEpsilon, _CMP_LT_OQ);
+            unsigned periodic = (nearRe & nearIm) & live & ~done;
+            stats.periodic += __builtin_popcount(periodic);
+            interior |= periodic;
+        }
+        if (derivative) {
+            __m512d norm = _mm512_add_pd(_mm512_mul_pd(dr, dr), _mm512_mul_pd(di, di));
+            unsigned attracting = _mm512_cmp_pd_mask(norm, derivativeEpsilon2, _CMP_LT_OQ) & live & ~done & ~interior;
+            stats.attracting += __builtin_popcount(attracting);
+            interior |= attracting;
+        }
+        if (done | interior) {
+            it = _mm512_mask_mov_epi64(it, static_cast<__mmask8>(interior), vmax);
+            _mm512_store_pd(s.v[0], x);
+            _mm512_store_pd(s.v[1], y);
+            _mm512_store_pd(s.v[2], cr);
+            _mm512_store_pd(s.v[3], ci);
+            _mm512_store_si512(s.it, it);
+            if (distance) {
+                alignas(64) double eRe[8], eIm[8];
+                _mm512_store_pd(eRe, er);
+                _mm512_store_pd(eIm, ei);
+                s.estimate(done | interior, eRe, eIm, k, maxIterations, estimate.distance);
+            }
+            s.finish(done | interior, iterations);
+            x = _mm512_load_pd(s.v[0]);
+            y = _mm512_load_pd(s.v[1]);
+            cr = _mm512_load_pd(s.v[2]);
+            ci = _mm512_load_pd(s.v[3]);
+            it = _mm512_load_si512(s.it);
+            if (periodicity || derivative) {
+                live = _mm512_cmpge_epi64_mask(it, zero);
+                __mmask8 fresh = _mm512_cmpeq_epi64_mask(it, zero);
+                sx = _mm512_mask_mov_pd(sx, fresh, nan);
+                sy = _mm512_mask_mov_pd(sy, fresh, nan);
+                check = _mm512_mask_mov_epi64(check, fresh, one);
+                dr = _mm512_mask_mov_pd(dr, fresh, dOne);
+                di = _mm512_mask_mov_pd(di, fresh, dZero);
+            }
+            if (distance) {
+                __mmask8 fresh = _mm512_cmpeq_epi64_mask(it, zero);
+                er = _mm512_mask_mov_pd(er, fresh, eStart);
+                ei = _mm512_mask_mov_pd(ei, fresh, dZero);
+            }
+            continue;
+        }
+        if (periodicity) {
+            __mmask8 save = _mm512_cmpeq_epi64_mask(it, check);
+            sx = _mm512_mask_mov_pd(sx, save, x);
+            sy = _mm512_mask_mov_pd(sy, save, y);
+            check = _mm512_mask_add_epi64(check, save, check, check);
+        }
+        if (derivative) {
+            __mmask8 later = _mm512_cmpneq_epi64_mask(it, zero);
+            __m512d nr = _mm512_sub_pd(_mm512_mul_pd(x, dr), _mm512_mul_pd(y, di));
+            __m512d ni = _mm512_add_pd(_mm512_mul_pd(x, di), _mm512_mul_pd(y, dr));
+            dr = _mm512_mask_add_pd(dr, later, nr, nr);
+            di = _mm512_mask_add_pd(di, later, ni, ni);
+        }
+        if (distance) {
+            __m512d nr = _mm512_sub_pd(_mm512_mul_pd(x, er), _mm512_mul_pd(y, ei));
+            __m512d ni = _mm512_add_pd(_mm512_mul_pd(x, ei), _mm512_mul_pd(y, er));
+            er = _mm512_add_pd(_mm512_add_pd(nr, nr), dk);
+            ei = _mm512_add_pd(ni, ni);
+        }
+        __m512d xy = _mm512_mul_pd(x, y);
+        x = _mm512_add_pd(_mm512_sub_pd(x2, y2), cr);
+        y = _mm512_add_pd(_mm512_add_pd(xy, xy), ci);
+        it = _mm512_add_epi64(it, one);
+    }
+}
+
+// The double-double operations of doubledouble.h, four and eight lanes at a time
+struct DoubleDouble4 {
+    __m256d hi, lo;
+};
+
+__attribute__((target("avx2,fma"))) static inline DoubleDouble4 quickTwoSum(__m256d a, __m256d b)
+{
+    __m256d s = _mm256_add_pd(a, b);
+    return { s, _mm256_sub_pd(b, _mm256_sub_pd(s, a)) };
+}
+
+__attribute__((target("avx2,fma"))) static inline DoubleDouble4 operator+(DoubleDouble4 a, DoubleDouble4 b)
+{
+    __m256d s = _mm256_add_pd(a.hi, b.hi);
+    __m256d bb = _mm256_sub_pd(s, a.hi);
+    __m256d e = _mm256_add_pd(_mm256_sub_pd(a.hi, _mm256_sub_pd(s, bb)), _mm256_sub_pd(b.hi, bb));
+    return quickTwoSum(s, _mm256_add_pd(e, _mm256_add_pd(a.lo, b.lo)));
+}
+
+__attribute__((target("avx2,fma"))) static inline DoubleDouble4 operator-(DoubleDouble4 a, DoubleDouble4 b)
+{
+    __m256d s = _mm256_sub_pd(a.hi, b.hi);
+    __m256d bb = _mm256_sub_pd(s, a.hi);
+    __m256d e = _mm256_sub_pd(_mm256_sub_pd(a.hi, _mm256_sub_pd(s, bb)), _mm256_add_pd(b.hi, bb));
+    return quickTwoSum(s, _mm256_add_pd(e, _mm256_sub_pd(a.lo, b.lo)));
+}
+
+__attribute__((target("avx2,fma"))) static inline DoubleDouble4 operator*(DoubleDouble4 a, DoubleDouble4 b)
+{
+    __m256d p = _mm256_mul_pd(a.hi, b.hi);
+    __m256d e = _mm256_fmsub_pd(a.hi, b.hi, p);
+    return quickTwoSum(p, _mm256_add_pd(e, _mm256_add_pd(_mm256_mul_pd(a.hi, b.lo), _mm256_mul_pd(a.lo, b.hi))));
+}
+
+__attribute__((target("avx2,fma"))) static inline DoubleDouble4 square(DoubleDouble4 a)
+{
+    __m256d p = _mm256_mul_pd(a.hi, a.hi);
+    __m256d e = _mm256_fmsub_pd(a.hi, a.hi, p);
+    __m256d t = _mm256_mul_pd(a.hi, a.lo);
+    return quickTwoSum(p, _mm256_add_pd(e, _mm256_add_pd(t, t)));
+}
+
+__attribute__((target("avx2,fma"))) static inline DoubleDouble4 twice(DoubleDouble4 a)
+{
+    return { _mm256_add_pd(a.hi, a.hi), _mm256_add_pd(a.lo, a.lo) };
+}
+
+__attribute__((target("avx2,fma"))) static void escapeAvx2DoubleDouble(const DoubleDoubleBatch &batch, int maxIterations, int *iterations)
+{
+    const double *inputs[] = { batch.zRe, batch.zReLo, batch.zIm, batch.zImLo, batch.cRe, batch.cReLo, batch.cIm, batch.cImLo };
+    LaneState<4, 8> s(inputs, batch.count);
+    const __m256d four = _mm256_set1_pd(4.0);
+    const __m256i vmax = _mm256_set1_epi64x(maxIterations);
+    const __m256i one = _mm256_set1_epi64x(1);
+    DoubleDouble4 x { _mm256_load_pd(s.v[0]), _mm256_load_pd(s.v[1]) };
+    DoubleDouble4 y { _mm256_load_pd(s.v[2]), _mm256_load_pd(s.v[3]) };
+    DoubleDouble4 cr { _mm256_load_pd(s.v[4]), _mm256_load_pd(s.v[5]) };
+    DoubleDouble4 ci { _mm256_load_pd(s.v[6]), _mm256_load_pd(s.v[7]) };
+    __m256i it = _mm256_load_si256(reinterpret_cast<const __m256i *>(s.it));
+
+    while (s.active > 0) {
+        DoubleDouble4 x2 = square(x);
+        DoubleDouble4 y2 = square(y);
+        __m256d escaped = _mm256_cmp_pd(_mm256_add_pd(x2.hi, y2.hi), four, _CMP_NLE_UQ);
+        __m256d limit = _mm256_castsi256_pd(_mm256_cmpeq_epi64(it, vmax));
+        unsigned done = _mm256_movemask_pd(_mm256_or_pd(escaped, limit));
+        if (done) {
+            _mm256_store_pd(s.v[0], x.hi);
+            _mm256_store_pd(s.v[1], x.lo);
+            _mm256_store_pd(s.v[2], y.hi);
+            _mm256_store_pd(s.v[3], y.lo);
+            _mm256_store_pd(s.v[4], cr.hi);
+            _mm256_store_pd(s.v[5], cr.lo);
+            _mm256_store_pd(s.v[6], ci.hi);
+            _mm256_store_pd(s.v[7], ci.lo);
+            _mm256_store_si256(reinterpret_cast<__m256i *>(s.it), it);
+            s.finish(done, iterations);
+            x = { _mm256_load_pd(s.v[0]), _mm256_load_pd(s.v[1]) };
+            y = { _mm256_load_pd(s.v[2]), _mm256_load_pd(s.v[3]) };
+            cr = { _mm256_load_pd(s.v[4]), _mm256_load_pd(s.v[5]) };
+            ci = { _mm256_load_pd(s.v[6]), _mm256_load_pd(s.v[7]) };
+            it = _mm256_load_si256(reinterpret_cast<const __m256i *>(s.it));
+            continue;
+        }
+        DoubleDouble4 xy = x * y;
+        x = (x2 - y2) + cr;
+        y = twice(xy) + ci;
+        it = _mm256_add_epi64(it, one);
+    }
+}
+
+struct DoubleDouble8 {
+    __m512d hi, lo;
+};
+
+__attribute__((target("avx512f"))) static inline DoubleDouble8 quickTwoSum(__m512d a, __m512d b)
+{
+    __m512d s = _mm512_add_pd(a, b);
+    return { s, _mm512_sub_pd(b, _mm512_sub_pd(s, a)) };
+}
+
+__attribute__((target("avx512f"))) static inline DoubleDouble8 operator+(DoubleDouble8 a, DoubleDouble8 b)
+{
+    __m512d s = _mm512_add_pd(a.hi, b.hi);
+    __m512d bb = _mm512_sub_pd(s, a.hi);
+    __m512d e = _mm512_add_pd(_mm512_sub_pd(a.hi, _mm512_sub_pd(s, bb)), _mm512_sub_pd(b.hi, bb));
+    return quickTwoSum(s, _mm512_add_pd(e, _mm512_add_pd(a.lo, b.lo)));
+}
+
+__attribute__((target("avx512f"))) static inline DoubleDouble8 operator-(DoubleDouble8 a, DoubleDouble8 b)
+{
+    __m512d s = _mm512_sub_pd(a.hi, b.hi);
+    __m512d bb = _mm512_sub_pd(s, a.hi);
+    __m512d e = _mm512_sub_pd(_mm512_sub_pd(a.hi, _mm512_sub_pd(s, bb)), _mm512_add_pd(b.hi, bb));
+    return quickTwoSum(s, _mm512_add_pd(e, _mm512_sub_pd(a.lo, b.lo)));
+}
+
+__attribute__((target("avx512f"))) static inline DoubleDouble8 operator*(DoubleDouble8 a, DoubleDouble8 b)
+{
+    __m512d p = _mm512_mul_pd(a.hi, b.hi);
+    __m512d e = _mm512_fmsub_pd(a.hi, b.hi, p);
+    return quickTwoSum(p, _mm512_add_pd(e, _mm512_add_pd(_mm512_mul_pd(a.hi, b.lo), _mm512_mul_pd(a.lo, b.hi))));
+}
+
+__attribute__((target("avx512f"))) static inline DoubleDouble8 square(DoubleDouble8 a)
+{
+    __m512d p = _mm512_mul_pd(a.hi, a.hi);
+    __m512d e = _mm512_fmsub_pd(a.hi, a.hi, p);
+    __m512d t = _mm512_mul_pd(a.hi, a.lo);
+    return quickTwoSum(p, _mm512_add_pd(e, _mm512_add_pd(t, t)));
+}
+
+__attribute__((target("avx512f"))) static inline DoubleDouble8 twice(DoubleDouble8 a)
+{
+    return { _mm512_add_pd(a.hi, a.hi), _mm512_add_pd(a.lo, a.lo) };
+}
+
+
+__attribute__((target("avx512f"))) static void escapeAvx512DoubleDouble(const DoubleDoubleBatch &batch, int maxIterations, int *iterations)
+{
+    const double *inputs[] = { batch.zRe, batch.zReLo, batch.zIm, batch.zImLo, batch.cRe, batch.cReLo, batch.cIm, batch.cImLo };
+    LaneState<8, 8> s(inputs, batch.count);
+    const __m512d four = _mm512_set1_pd(4.0);
+    const __m512i vmax = _mm512_set1_epi64(maxIterations);
+    const __m512i one = _mm512_set1_epi64(1);
+    DoubleDouble8 x { _mm512_load_pd(s.v[0]), _mm512_load_pd(s.v[1]) };
+    DoubleDouble8 y { _mm512_load_pd(s.v[2]), _mm512_load_pd(s.v[3]) };
+    DoubleDouble8 cr { _mm512_load_pd(s.v[4]), _mm512_load_pd(s.v[5]) };
+    DoubleDouble8 ci { _mm512_load_pd(s.v[6]), _mm512_load_pd(s.v[7]) };
+    __m512i it = _mm512_load_si512(s.it);
+
+    while (s.active > 0) {
+        DoubleDouble8 x2 = square(x);
+        DoubleDouble8 y2 = square(y);
+        __mmask8 escaped = _mm512_cmp_pd_mask(_mm512_add_pd(x2.hi, y2.hi), four, _CMP_NLE_UQ);
+        __mmask8 limit = _mm512_cmpeq_epi64_mask(it, vmax);
+        unsigned done = escaped | limit;
+        if (done) {
+            _mm512_store_pd(s.v[0], x.hi);
+            _mm512_store_pd(s.v[1], x.lo);
+            _mm512_store_pd(s.v[2], y.hi);
+            _mm512_store_pd(s.v[3], y.lo);
+            _mm512_store_pd(s.v[4], cr.hi);
+            _mm512_store_pd(s.v[5], cr.lo);
+            _mm512_store_pd(s.v[6], ci.hi);
+            _mm512_store_pd(s.v[7], ci.lo);
+            _mm512_store_si512(s.it, it);
+            s.finish(done, iterations);
+            x = { _mm512_load_pd(s.v[0]), _mm512_load_pd(s.v[1]) };
+            y = { _mm512_load_pd(s.v[2]), _mm512_load_pd(s.v[3]) };
+            cr = { _mm512_load_pd(s.v[4]), _mm512_load_pd(s.v[5]) };
+            ci = { _mm512_load_pd(s.v[6]), _mm512_load_pd(s.v[7]) };
+            it = _mm512_load_si512(s.it);
+            continue;
+        }
+        DoubleDouble8 xy = x * y;
+        x = (x2 - y2) + cr;
+        y = twice(xy) + ci;
+        it = _mm512_add_epi64(it, one);
+    }
+}
+
+static unsigned long long getXcr0()
+{
+    unsigned eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+}
+
+#endif
+
+KernelIsa detectKernelIsa()
+{
+#if KERNEL_X86
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) {
+        return KernelIsa::Scalar;
+    }
+    // the double-double kernels need fused multiply-add, every AVX2 CPU has it anyway
+    const bool fma = ecx & bit_FMA;
+    // the OS has to save the vector registers on context switches too: ymm (bits 1-2), zmm/opmask (bits 5-7)
+    auto xcr0 = getXcr0();
+    if ((xcr0 & 0x06) != 0x06 || !__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return KernelIsa::Scalar;
+    }
+    if ((ebx & bit_AVX512F) && (xcr0 & 0xe6) == 0xe6) {
+        return KernelIsa::Avx512;
+    }
+    if ((ebx & bit_AVX2) && fma) {
+        return KernelIsa::Avx2;
+    }
+#endif
+    return KernelIsa::Scalar;
+}
+
+// picks the instantiation for the enabled checks and the distance estimate
+template <template <bool, bool, bool> class Kernel>
+static void escapeWithChecks(const EscapeBatch &batch, int maxIterations, const InteriorChecks &checks, const DistanceEstimate &estimate, int *iterations,
+    InteriorStats &stats)
+{
+    using Run = void (*)(const EscapeBatch &, int, const InteriorChecks &, const DistanceEstimate &, int *, InteriorStats &);
+    static constexpr Run instances[] = { Kernel<false, false, false>::run, Kernel<false, false, true>::run, Kernel<false, true, false>::run,
+        Kernel<false, true, true>::run, Kernel<true, false, false>::run, Kernel<true, false, true>::run, Kernel<true, true, false>::run,
+        Kernel<true, true, true>::run };
+    instances[checks.periodicity * 4 + checks.derivative * 2 + (estimate.distance != nullptr)](batch, maxIterations, checks, estimate, iterations, stats);
+}
+
+template <bool periodicity, bool derivative, bool distance>
+struct ScalarKernel {
+    static void run(const EscapeBatch &batch, int maxIterations, const InteriorChecks &checks, const DistanceEstimate &estimate, int *iterations,
+        InteriorStats &stats)
+    {
+        escapeScalar<periodicity, derivative, distance>(batch, maxIterations, checks, estimate, iterations, stats);
+    }
+};
+
+#if KERNEL_X86
+template <bool periodicity, bool derivative, bool distance>
+struct Avx2Kernel {
+    static void run(const EscapeBatch &batch, int maxIterations, const InteriorChecks &checks, const DistanceEstimate &estimate, int *iterations,
+        InteriorStats &stats)
+    {
+        escapeAvx2<periodicity, derivative, distance>(batch, maxIterations, checks, estimate, iterations, stats);
+    }
+};
+
+template <bool periodicity, bool derivative, bool distance>
+struct Avx512Kernel {
+    static void run(const EscapeBatch &batch, int maxIterations, const InteriorChecks &checks, const DistanceEstimate &estimate, int *iterations,
+        InteriorStats &stats)
+    {
+        escapeAvx512<periodicity, derivative, distance>(batch, maxIterations, checks, estimate, iterations, stats);
+    }
+};
+#endif
+
+EscapeKernel getEscapeKernel(KernelIsa isa)
+{
+    switch (isa) {
+#if KERNEL_X86
+    case KernelIsa::Avx512: return escapeWithChecks<Avx512Kernel>;
+    case KernelIsa::Avx2: return escapeWithChecks<Avx2Kernel>;
+#endif
+    default: return escapeWithChecks<ScalarKernel>;
+    }
+}
+
+DoubleDoubleKernel getDoubleDoubleKernel(KernelIsa isa)
+{
+    switch (isa) {
+#if KERNEL_X86
+    case KernelIsa::Avx512: return escapeAvx512DoubleDouble;
+    case KernelIsa::Avx2: return escapeAvx2DoubleDouble;
+#endif
+    default: return escapeScalarDoubleDouble;
+    }
+}
+
+const char *getKernelIsaName(KernelIsa isa)
+{
+    switch (isa) {
+    case KernelIsa::Avx512: return "avx512";
+    case KernelIsa::Avx2: return "avx2";
+    default: return "scalar";
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <algorithm>
+
+enum class KernelIsa { Scalar, Avx2, Avx512 };
+
+// Escape-time input for a batch of points, structure of arrays so the SIMD kernels can load lanes directly
+struct EscapeBatch {
+    const double *zRe;
+    const double *zIm;
+    const double *cRe;
+    const double *cIm;
+    int count;
+};
+
+// Early exits for points that never escape, they get maxIterations right away
+struct InteriorChecks {
+    // Brent cycle detection: z is saved at iterations 1, 2, 4, 8, ... and an orbit that comes back to it is periodic
+    bool periodicity = true;
+    // dz/dz0 shrinking below derivativeEpsilon means the orbit is caught by an attracting cycle
+    bool derivative = false;
+
+    double periodicityEpsilon = 1e-14;
+    double derivativeEpsilon = 1e-12;
+
+    // Fixed tolerances are too loose for deep views, an orbit that only comes close to a cycle would count as
+    // interior. Both shrink to spacing^2 once that is smaller, far below the pixel spacing at any depth.
+    void scaleTo(double pixelSpacing)
+    {
+        periodicityEpsilon = std::min(1e-14, pixelSpacing * pixelSpacing);
+        derivativeEpsilon = std::min(1e-12, pixelSpacing * pixelSpacing);
+    }
+};
+
+// number of points each check caught
+struct InteriorStats {
+    long long periodic = 0;
+    long long attracting = 0;
+};
+
+// Exterior distance estimation: the kernel also carries the derivative of z with respect to c (Mandelbrot set) or to
+// z0 (Julia sets, julia = true) and writes d = 2 * |z| * log|z| / |dz| for every escaped point, 0 for the others.
+// The distance to the set is between d / 4 and d. A separate instantiation of the kernels, so the derivative costs
+// nothing while distance is nullptr.
+struct DistanceEstimate {
+    double *distance = nullptr;
+    bool julia = false;
+
+    // an escaped point is iterated on to this |z|^2 first, log|z| / 2^n is then close to the Green's function
+    static constexpr double escapeRadius2 = 1e8;
+};
+
+// Iterates z = z^2 + c for every point of the batch until |z| > 2.0 or maxIterations is reached.
+// All kernels evaluate the exact same sequence of double operations, so their results are identical.
+using EscapeKernel = void (*)(const EscapeBatch &batch, int maxIterations, const InteriorChecks &checks, const DistanceEstimate &estimate, int *iterations,
+    InteriorStats &stats);
+
+// Same as EscapeBatch in double-double precision, every coordinate is hi + lo
+struct DoubleDoubleBatch {
+    const double *zRe, *zReLo;
+    const double *zIm, *zImLo;
+    const double *cRe, *cReLo;
+    const double *cIm, *cImLo;
+    int count;
+};
+
+// Iterates in double-double arithmetic (see doubledouble.h), for views whose pixels are too close together for
+// doubles. Escape is decided on the high parts alone. Like the double kernels, all instruction sets give identical
+// results.
+using DoubleDoubleKernel = void (*)(const DoubleDoubleBatch &batch, int maxIterations, int *iterations);
+
+// Best instruction set supported by both the CPU and the OS (cpuid + xgetbv); Avx2 includes FMA
+KernelIsa detectKernelIsa();
+EscapeKernel getEscapeKernel(KernelIsa isa);
+DoubleDoubleKernel getDoubleDoubleKernel(KernelIsa isa);
+const char *getKernelIsaName(KernelIsa isa);
@@ -16,16 +16,28 @@
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
 #include "mandelbrot.h"
+#include "cmdline.h"
 #include <cstdio>
 
 int main(int argc, char *argv[])
 {
     ShaderType shaderType = ShaderType::Mandelbrot;
-    if (argc > 1) {
-        if (std::string(argv[1]) == "--julia") {
+    Backend backend = Backend::Auto;
+    CpuRenderer::Options cpuOptions;
+    bool printCpuStats = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--julia") {
             shaderType = ShaderType::Julia;
+        } else if (std::string(argv[i]) == "--cpu") {
+            backend = Backend::Cpu;
+        } else if (std::string(argv[i]) == "--gpu") {
+            backend = Backend::Gpu;
+        } else if (std::string(argv[i]) == "--stats") {
+            printCpuStats = true;
+        } else {
+            parseCpuOption(argc, argv, i, cpuOptions);
         }
     }
-    Mandelbrot m({ 1000, 1000, "jet", false, shaderType });
+    Mandelbrot m({ 1000, 1000, "jet", false, shaderType, backend, cpuOptions, printCpuStats });
     return m.run();
 }
\ No newline at end of file
@@ -17,12 +17,16 @@
 
 #include <SFML/Graphics.hpp>
 #include <complex>
+#include <cerrno>
 #include <cstdio>
+#include <cstring>
 #include "mandelbrot.h"
 #include <functional>
 #include <utility>
 #include "profile.h"
 #include "colormap/palettes.hpp"
+#include "cpurenderer.h"
+#include "progressiverenderer.h"
 
 template <typename T>
 T constexpr mapToRange(T v, T vMin, T vMax, T toMin, T toMax)
@@ -43,11 +47,15 @@ sf::Vector2f GetWorldMouse(sf::RenderWindow &window)
 }
 
 Mandelbrot::Mandelbrot(const Config &config)
-    : mWidth(config.width), mHeight(config.height), mPallete(config.palleteName), mIsColorMapReversed(config.palleteReversed), mShaderType(config.shaderType)
+    : mWidth(config.width), mHeight(config.height), mPallete(config.palleteName), mIsColorMapReversed(config.palleteReversed), mShaderType(config.shaderType), mBackend(config.backend), mPrintCpuStats(config.printCpuStats || config.cpuOptions.verify)
 {
+    mCpuRenderer.setOptions(config.cpuOptions);
+    if (!config.cpuOptions.tileStore.empty() && !mCpuRenderer.hasTileStore()) {
+        printf("Error opening tile store %s: %s\n", config.cpuOptions.tileStore.c_str(), strerror(errno));
+    }
     updateColorMap();
-    for (auto [p, _] : colormap::palettes) {
-        mPalletes.push_back(p);
+    for (auto const &p : colormap::palettes) {
+        mPalletes.emplace_back(p.name);
     }
 }
 
@@ -73,7 +81,7 @@ void Mandelbrot::handleEvent(sf::RenderWindow &window)
             } else if (event.key.code == sf::Keyboard::Right) {
                 mPlaneCenter.x += mPlaneSize.x / 10;
             } else if (event.key.code == sf::Keyboard::Add) {
-                setMaxIterations(std::clamp((int)(mMaxIterations * 1.1), mMaxIterations + 1, CONFIG_ITERATION_LIMIT - 1));
+                setMaxIterations(std::clamp((int)(mMaxIterations * 1.1), mMaxIterations + 1, getIterationLimit() - 1));
             } else if (event.key.code == sf::Keyboard::Subtract) {
                 setMaxIterations(std::clamp((int)(mMaxIterations * 0.9), 1, mMaxIterations - 1));
             } else if (event.key.code == sf::Keyboard::PageDown) {
@@ -133,21 +141,23 @@ void Mandelbrot::handleEvent(sf::RenderWindow &window)
             }
         }
     }
+    updateCenterPrecision();
 }
 
-Mandelbrot::Mitype Mandelbrot::mapToPlane(Mitype v, Mitype size, Mitype planeCenter, Mitype planeSize) const
+// the result is relative to the plane center, which alone needs more than Mitype precision at deep zooms
+Mandelbrot::Mitype Mandelbrot::mapToPlane(Mitype v, Mitype size, Mitype planeSize) const
 {
-    return mapToRange(v, 0.0, static_cast<Mitype>(size), planeCenter - planeSize / 2, planeCenter + planeSize / 2);
+    return mapToRange(v, 0.0, static_cast<Mitype>(size), -planeSize / 2, planeSize / 2);
 }
 
 Mandelbrot::Mitype Mandelbrot::mapToPlaneWidth(Mitype x) const
 {
-    return mapToPlane(static_cast<Mitype>(x), static_cast<Mitype>(mWidth), mPlaneCenter.x, mPlaneSize.x);
+    return mapToPlane(static_cast<Mitype>(x), static_cast<Mitype>(mWidth), mPlaneSize.x);
 }
 
 Mandelbrot::Mitype Mandelbrot::mapToPlaneHeight(Mitype y) const
 {
-    return mapToPlane(static_cast<Mitype>(y), static_cast<Mitype>(mHeight), mPlaneCenter.y, mPlaneSize.y);
+    return mapToPlane(static_cast<Mitype>(y), static_cast<Mitype>(mHeight), mPlaneSize.y);
 }
 
 Mandelbrot::Vector2d Mandelbrot::getPlaneMouse(sf::RenderWindow &window) const
@@ -156,9 +166,18 @@ Mandelbrot::Vector2d Mandelbrot::getPlaneMouse(sf::RenderWindow &window) const
     return { mapToPlaneWidth(wmouse.x), mapToPlaneHeight(wmouse.y) };
 }
 
+void Mandelbrot::updateCenterPrecision()
+{
+    auto limbs = Mhptype::getFractionLimbs(std::min(mPlaneSize.x / mWidth, mPlaneSize.y / mHeight));
+    if (limbs > mPlaneCenter.x.fractionLimbs()) {
+        mPlaneCenter.x.setFractionLimbs(limbs);
+        mPlaneCenter.y.setFractionLimbs(limbs);
+    }
+}
+
 void Mandelbrot::setMaxIterations(int maxIterations)
 {
-    if (maxIterations >= CONFIG_ITERATION_LIMIT || maxIterations <= 1 || maxIterations == mMaxIterations) {
+    if (maxIterations >= getIterationLimit() || maxIterations <= 1 || maxIterations == mMaxIterations) {
         return;
     }
     mMaxIterations = maxIterations;
@@ -169,29 +188,65 @@ void Mandelbrot::updateColorMap()
 {
     auto const &colorMap = colormap::palettes.at(mPallete);
 
+    // exact colors, the palette's lookup table would merge neighbouring counts beyond 4096 iterations
+    mColors.resize(mMaxIterations + 1);
     for (auto i = 0; i <= mMaxIterations; ++i) {
         auto ratio = (double)i / mMaxIterations;
         auto v = colorMap(mIsColorMapReversed ? 1 - ratio : ratio);
-        mVec4Colors[i] = sf::Color(v.getRed().getValue(), v.getGreen().getValue(), v.getBlue().getValue());
+        mColors[i] = sf::Color(v.getRed().getValue(), v.getGreen().getValue(), v.getBlue().getValue());
+        if (i < CONFIG_ITERATION_LIMIT) {
+            mVec4Colors[i] = mColors[i];
+        }
     }
+    ++mColorMapGeneration;
     printf("Using colormap '%s'%s max iterations: %d\n", mPallete.c_str(), mIsColorMapReversed ? "(reversed)" : "", mMaxIterations);
 }
 
+int Mandelbrot::getIterationLimit() const
+{
+    // the GPU keeps the whole color map in uniform registers, the CPU backend has no such restriction
+    return mBackend == Backend::Cpu ? CONFIG_CPU_ITERATION_LIMIT : CONFIG_ITERATION_LIMIT;
+}
+
+View Mandelbrot::getView() const
+{
+    View view;
+    view.width = mWidth;
+    view.height = mHeight;
+    view.centerRe = mPlaneCenter.x;
+    view.centerIm = -mPlaneCenter.y; // sfml has the y axis pointing down
+    view.planeWidth = mPlaneSize.x;
+    view.planeHeight = mPlaneSize.y;
+    view.maxIterations = mMaxIterations;
+    view.type = mShaderType;
+    view.juliaConst = { mConst.x, mConst.y };
+    return view;
+}
+
 int Mandelbrot::run()
 {
     sf::RenderWindow window(sf::VideoMode(mWidth, mHeight), "Mandelbrot");
+
+    if (mBackend == Backend::Auto) {
+        mBackend = sf::Shader::isAvailable() ? Backend::Gpu : Backend::Cpu;
+    }
+    return mBackend == Backend::Gpu ? runGpu(window) : runCpu(window);
+}
+
+int Mandelbrot::runGpu(sf::RenderWindow &window)
+{
     const auto size = sf::Vector2f { (float)mWidth, (float)mHeight };
     sf::Shader shader;
     const sf::RectangleShape plane(size);
     std::map<ShaderType, std::string> shaderFiles = { { ShaderType::Mandelbrot, "mandelbrotShader.frag" }, { ShaderType::Julia, "juliaShader.frag" } };
 
-    if (!shader.loadFromFile(shaderFiles.at(mShaderType), sf::Shader::Fragment)) {
-        printf("Error loading shader");
+    if (!shader.isAvailable()) {
+        printf("Shaders not available");
         return 1;
     }
 
-    if (!shader.isAvailable()) {
-        printf("Shaders not available");
+    if (!shader.loadFromFile(shaderFiles.at(mShaderType), sf::Shader::Fragment)) {
+        printf("Error loading shader");
         return 1;
     }
 
@@ -200,8 +255,8 @@ int Mandelbrot::run()
         handleEvent(window);
         window.clear();
 
-        shader.setUniform("u_size", mPlaneSize);
-        shader.setUniform("u_center", sf::Vector2f(mPlaneCenter.x, -mPlaneCenter.y)); // shaders have inverted x in respect to sfml
+        shader.setUniform("u_size", sf::Vector2f(mPlaneSize));
+        shader.setUniform("u_center", sf::Vector2f(mPlaneCenter.x.toDouble(), -mPlaneCenter.y.toDouble())); // shaders have inverted x in respect to sfml
         shader.setUniform("u_maxIterations", mMaxIterations);
 
         if (mShaderType == ShaderType::Julia) {
@@ -215,3 +270,114 @@ int Mandelbrot::run()
     }
     return 0;
 }
+
+int Mandelbrot::runCpu(sf::RenderWindow &window)
+{
+    sf::Texture texture;
+    if (!texture.create(mWidth, mHeight)) {
+        printf("Error creating texture");
+        return 1;
+    }
+    const sf::Sprite sprite(texture);
+    IterationBuffer iterations;
+    std::vector<sf::Uint8> pixels(static_cast<size_t>(mWidth) * mHeight * 4);
+    View lastView;
+    lastView.width = 0;
+    auto lastColorMapGeneration = mColorMapGeneration - 1;
+    // frames are rendered in the background, a pass at a time
+    ProgressiveRenderer renderer(mCpuRenderer);
+    // anti-aliasing samples and distance estimates of the finished frame
+    CpuRenderer::Supersamples samples;
+    std::vector<double> distances;
+    double spacing = 0.0;
+    // of the iterations in the buffer, the color map may already be shorter
+    int bufferMaxIterations = 0;
+
+    printf("Using CPU backend (%u threads, %s kernel)\n", mCpuRenderer.threads(), getKernelIsaName(mCpuRenderer.isa()));
+    while (window.isOpen()) {
+        handleEvent(window);
+
+        // unlike the shader, a CPU frame is expensive, so only recompute when something changed; a changed view
+        // abandons the rest of the old frame right away
+        auto view = getView();
+        if (view != lastView) {
+            renderer.request(view);
+            lastView = view;
+        }
+        ProgressiveRenderer::Pass pass;
+        const bool passRendered = renderer.takePass(iterations, pass);
+        if (passRendered) {
+            samples = std::move(pass.samples);
+            distances = std::move(pass.distances);
+            spacing = lastView.pixelSpacing();
+            bufferMaxIterations = lastView.maxIterations;
+        }
+        if (passRendered && mPrintCpuStats) {
+            // time to first pixel is what makes panning feel responsive
+            if (pass.first) {
+                printf("First pass (step %d) after %.1f ms\n", pass.step, pass.latency * 1e3);
+            }
+            if (pass.step == 1) {
+                const auto &stats = pass.stats;
+                printf("Frame after %.1f ms. Pixels: %lld computed, %lld filled, %lld mirrored, %lld cached; interior shortcuts: %lld cardioid/bulb, %lld periodic, "
+                       "%lld attracting\n",
+                    pass.latency * 1e3, stats.computedPixels, stats.filledPixels, stats.mirroredPixels, stats.cachedPixels, stats.cardioidPixels,
+                    stats.periodicPixels, stats.attractingPixels);
+                if (mCpuRenderer.options().antialias > 0) {
+                    printf("Anti-aliasing: %lld pixels, %lld extra samples, %lld edge pixels far from the set\n", stats.antialiasedPixels, stats.antialiasSamples,
+                        stats.distantPixels);
+                }
+                if (mCpuRenderer.options().verify) {
+                    printf("Verify: %lld of %lld pixels differ from brute force\n", stats.mismatchedPixels, static_cast<long long>(mWidth) * mHeight);
+                }
+            }
+        }
+        // after a change of the iteration count the colors wait for the first pass at the new count
+        if ((passRendered || mColorMapGeneration != lastColorMapGeneration) && iterations.width == mWidth && bufferMaxIterations == mMaxIterations) {
+            auto *pixel = pixels.data();
+            for (int y = 0; y < mHeight; ++y) {
+                const int *row = iterations.row(y);
+                for (int x = 0; x < mWidth; ++x, pixel += 4) {
+                    const auto &color = mColors[row[x]];
+                    pixel[0] = color.r;
+                    pixel[1] = color.g;
+                    pixel[2] = color.b;
+                    pixel[3] = 255;
+                }
+            }
+            // exterior pixels closer to the set than a pixel get its color, a boundary one pixel thin from one sample
+            if (distances.size() == pixels.size() / 4) {
+                const auto &color = mColors[mMaxIterations];
+                for (size_t i = 0; i < distances.size(); ++i) {
+                    if (distances[i] > 0.0 && distances[i] < spacing) {
+                        pixels[4 * i] = color.r;
+                        pixels[4 * i + 1] = color.g;
+                        pixels[4 * i + 2] = color.b;
+                    }
+                }
+            }
+            // an anti-aliased pixel is the mean color of all its samples
+            for (size_t k = 0; k < samples.pixel.size(); ++k) {
+                auto *target = pixels.data() + static_cast<size_t>(samples.pixel[k]) * 4;
+                unsigned sum[3] = { target[0], target[1], target[2] };
+                for (int i = samples.first[k]; i < samples.first[k + 1]; ++i) {
+                    const auto &color = mColors[samples.counts[i]];
+                    sum[0] += color.r;
+                    sum[1] += color.g;
+                    sum[2] += color.b;
+                }
+                const unsigned n = samples.first[k + 1] - samples.first[k] + 1;
+                for (int c = 0; c < 3; ++c) {
+                    target[c] = static_cast<sf::Uint8>((sum[c] + n / 2) / n);
+                }
+            }
+            texture.update(pixels.data());
+            lastColorMapGeneration = mColorMapGeneration;
+        }
+
+        window.clear();
+        window.draw(sprite);
+        window.display();
+    }
+    return 0;
+}
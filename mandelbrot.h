@@ -25,8 +25,11 @@
 #include <string>
 #include "config.h"
 #include "colormap/colormap.hpp"
+#include "cpurenderer.h"
+#include "view.h"
 
-enum class ShaderType { Mandelbrot, Julia };
+// Auto picks the GPU when shaders are available and falls back to the CPU otherwise
+enum class Backend { Gpu, Cpu, Auto };
 
 class Mandelbrot
 {
@@ -37,6 +40,10 @@ public:
         std::string palleteName = "jet";
         bool palleteReversed = true;
         ShaderType shaderType = ShaderType::Mandelbrot;
+        Backend backend = Backend::Auto;
+        CpuRenderer::Options cpuOptions;
+        // print the pixel counts of every CPU frame (always on with cpuOptions.verify)
+        bool printCpuStats = false;
     };
     Mandelbrot(const Config &config);
     int run();
@@ -44,15 +51,22 @@ public:
 private:
     using Mitype = double;
     using Mtype = std::complex<Mitype>;
+    // high precision type of the plane center, everything relative to it is a Mitype
+    using Mhptype = FixedPoint;
     using Vector2d = sf::Vector2<double>;
 
     void handleEvent(sf::RenderWindow &window);
-    Mitype mapToPlane(Mitype v, Mitype size, Mitype planeCenter, Mitype planeSize) const;
+    Mitype mapToPlane(Mitype v, Mitype size, Mitype planeSize) const;
     Mitype mapToPlaneWidth(Mitype v) const;
     Mitype mapToPlaneHeight(Mitype v) const;
     Vector2d getPlaneMouse(sf::RenderWindow &window) const;
     void setMaxIterations(int maxIterations);
     void updateColorMap();
+    void updateCenterPrecision();
+    int getIterationLimit() const;
+    View getView() const;
+    int runGpu(sf::RenderWindow &window);
+    int runCpu(sf::RenderWindow &window);
 
     int mWidth;
     int mHeight;
@@ -60,11 +74,16 @@ private:
     std::string mPallete;
     bool mIsColorMapReversed;
     std::vector<std::string> mPalletes;
-    sf::Vector2<float> mPlaneSize { 3.0, 3.0 };
-    sf::Vector2<float> mPlaneCenter { -0.6, 0.0 };
+    Vector2d mPlaneSize { 3.0, 3.0 };
+    sf::Vector2<Mhptype> mPlaneCenter { -0.6, 0.0 };
     sf::Vector2<float> mConst { 0.0, 0.0 };
     sf::Vector2<float> mMousePosition { 0.0, 0.0 };
     std::array<sf::Glsl::Vec4, CONFIG_ITERATION_LIMIT> mVec4Colors;
+    std::vector<sf::Color> mColors;
+    unsigned mColorMapGeneration = 0;
     static auto constexpr maxColorValue = 255;
     ShaderType mShaderType = ShaderType::Mandelbrot;
+    Backend mBackend = Backend::Auto;
+    bool mPrintCpuStats = false;
+    CpuRenderer mCpuRenderer;
 };
@@ -0,0 +1,132 @@
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "perturbation.h"
+#include <algorithm>
+#include "bla.h"
+#include <iterator>
+
+void ReferenceOrbit::compute(const FixedPoint &re, const FixedPoint &im, int maxIterations)
+{
+    centerRe = re;
+    centerIm = im;
+    this->maxIterations = maxIterations;
+    zRe.assign(1, 0.0);
+    zIm.assign(1, 0.0);
+    computeOrbit(re, im, maxIterations, zRe, zIm);
+}
+
+void SeriesApproximation::compute(const ReferenceOrbit &orbit, double radius, double pixelSpacing)
+{
+    this->radius = radius;
+    this->pixelSpacing = pixelSpacing;
+    skip = 0;
+    std::fill(std::begin(coefficients), std::end(coefficients), 0.0);
+    if (radius <= 0.0) {
+        return;
+    }
+
+    // neighbouring pixels differ by about |b_1| * pixelSpacing / radius, the truncation error (estimated by the
+    // highest order term) has to stay well below that
+    const double bound = tolerance * pixelSpacing / radius;
+    const int last = static_cast<int>(orbit.zRe.size()) - 1;
+    std::complex<double> b[terms] = {};
+    std::complex<double> next[terms];
+    for (int n = 0; n < last; ++n) {
+        const std::complex<double> twoZ(2.0 * orbit.zRe[n], 2.0 * orbit.zIm[n]);
+        next[0] = twoZ * b[0] + radius;
+        for (int k = 1; k < terms; ++k) {
+            std::complex<double> sum = 0.0;
+            for (int i = 0; i < k; ++i) {
+                sum += b[i] * b[k - 1 - i];
+            }
+            next[k] = twoZ * b[k] + sum;
+        }
+        if (!(std::abs(next[terms - 1]) <= bound * std::abs(next[0]))) {
+            break;
+        }
+        std::copy(std::begin(next), std::end(next), b);
+        skip = n + 1;
+    }
+    std::copy(std::begin(b), std::end(b), coefficients);
+}
+
+std::complex<double> SeriesApproximation::evaluate(std::complex<double> dc) const
+{
+    const std::complex<double> u = dc / radius;
+    std::complex<double> dz = 0.0;
+    for (int k = terms - 1; k >= 0; --k) {
+        dz = (dz + coefficients[k]) * u;
+    }
+    return dz;
+}
+
+void escapePerturbed(const ReferenceOrbit &orbit, const SeriesApproximation *series, const BlaTable *bla, const double *dcRe, const double *dcIm, int count,
+    int maxIterations, int *iterations)
+{
+    const double *zr = orbit.zRe.data();
+    const double *zi = orbit.zIm.data();
+    const int last = static_cast<int>(orbit.zRe.size()) - 1;
+
+    for (int p = 0; p < count; ++p) {
+        const double cr = dcRe[p];
+        const double ci = dcIm[p];
+        double dr = 0.0;
+        double di = 0.0;
+        int m = 0;
+        int i = 0;
+        if (series && series->skip > 0) {
+            auto dz = series->evaluate({ cr, ci });
+            dr = dz.real();
+            di = dz.imag();
+            m = i = series->skip;
+        }
+        for (; i < maxIterations; ++i) {
+            double x = zr[m] + dr;
+            double y = zi[m] + di;
+            double mag = x * x + y * y;
+            if (!(mag <= 4.0)) {
+                break;
+            }
+            if (mag < dr * dr + di * di || m == last) {
+                dr = x;
+                di = y;
+                m = 0;
+            }
+            if (bla) {
+                int length;
+                if (auto step = bla->lookup(m, dr * dr + di * di, std::min(last, m + maxIterations - i), length)) {
+                    // dz' = A * dz + B * dc
+                    double nr = step->a.real() * dr - step->a.imag() * di + step->b.real() * cr - step->b.imag() * ci;
+                    di = step->a.real() * di + step->a.imag() * dr + step->b.real() * ci + step->b.imag() * cr;
+                    dr = nr;
+                    m += length;
+                    i += length - 1;
+                    continue;
+                }
+            }
+            // dz' = (2 * Z + dz) * dz + dc
+            double tr = 2.0 * zr[m] + dr;
+            double ti = 2.0 * zi[m] + di;
+            double nr = tr * dr - ti * di + cr;
+            di = tr * di + ti * dr + ci;
+            dr = nr;
+            ++m;
+        }
+        iterations[p] = i;
+    }
+}
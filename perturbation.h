@@ -0,0 +1,107 @@
+#pragma once
+
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Deep zoom by perturbation: a single reference point C is iterated at full precision, every pixel c = C + dc then
+// only iterates its difference dz to the reference orbit Z in hardware doubles:
+//   dz' = 2 * Z * dz + dz^2 + dc
+// When the orbit of a pixel gets closer to 0 than its distance to the reference (|Z + dz| < |dz|), or the reference
+// runs out, the pixel is rebased onto the start of the reference orbit (dz = Z + dz, restart at Z_0 = 0), which
+// avoids the classic perturbation glitches without extra references.
+
+#include <complex>
+#include <vector>
+#include "fixedpoint.h"
+
+class BlaTable;
+
+struct ReferenceOrbit {
+    FixedPoint centerRe;
+    FixedPoint centerIm;
+    int maxIterations = 0;
+    // Z_0 = 0 ... Z_n, ends after the first point that escaped (|Z| > 2.0) or at maxIterations
+    std::vector<double> zRe;
+    std::vector<double> zIm;
+
+    void compute(const FixedPoint &re, const FixedPoint &im, int maxIterations);
+    bool isValid() const { return !zRe.empty(); }
+};
+
+// Iterates z' = z^2 + c from z = 0 at the precision of re and appends every z after the first to zRe, zIm rounded to
+// doubles. T is Mitype (double) or Mhptype (FixedPoint); all temporaries are assigned in place, so after the first
+// iteration nothing allocates, and 2xy = (x + y)^2 - x^2 - y^2 makes it three squarings per iteration.
+template <typename T>
+void computeOrbit(const T &re, const T &im, int maxIterations, std::vector<double> &zRe, std::vector<double> &zIm)
+{
+    // zero at the precision of re
+    T x = re;
+    x -= re;
+    T y = x;
+    T x2 = x;
+    T y2 = x;
+    T xy2 = x;
+    for (int n = 0; n < maxIterations; ++n) {
+        x2 = x;
+        squareInPlace(x2);
+        y2 = y;
+        squareInPlace(y2);
+        if (!(toDouble(x2) + toDouble(y2) <= 4.0)) {
+            break;
+        }
+        xy2 = x;
+        xy2 += y;
+        squareInPlace(xy2);
+        xy2 -= x2;
+        xy2 -= y2;
+        x = x2;
+        x -= y2;
+        x += re;
+        y = xy2;
+        y += im;
+        zRe.push_back(toDouble(x));
+        zIm.push_back(toDouble(y));
+    }
+}
+
+// Taylor series of the pixel delta along the reference orbit, dz_n = sum(a_k * dc^k), which lets every pixel start
+// at iteration skip instead of 0. The series is kept in u = dc / radius (coefficients b_k = a_k * radius^k), so the
+// coefficients stay representable as doubles at any zoom depth:
+//   b_1' = 2 * Z * b_1 + radius
+//   b_k' = 2 * Z * b_k + sum(b_i * b_j, i + j = k)
+struct SeriesApproximation {
+    static constexpr int terms = 8;
+    // truncation error allowed relative to the difference between neighbouring pixels, small because the remaining
+    // iterations amplify it
+    static constexpr double tolerance = 1e-7;
+
+    int skip = 0;
+    double radius = 0.0;
+    double pixelSpacing = 0.0;
+    std::complex<double> coefficients[terms];
+
+    // radius is the largest |dc| that will be evaluated; skip is the last iteration at which the highest order term
+    // is still negligible for every pixel of that disc
+    void compute(const ReferenceOrbit &orbit, double radius, double pixelSpacing);
+    std::complex<double> evaluate(std::complex<double> dc) const;
+};
+
+// Escape-time iteration counts of the points reference + (dcRe[i], dcIm[i]), same stop condition as the plain kernels.
+// With a series the first series->skip iterations come from the approximation, with a bla table the pixels jump
+// ahead wherever one of its steps is valid. Both are optional.
+void escapePerturbed(const ReferenceOrbit &orbit, const SeriesApproximation *series, const BlaTable *bla, const double *dcRe, const double *dcIm, int count,
+    int maxIterations, int *iterations);
@@ -0,0 +1,106 @@
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "progressiverenderer.h"
+#include <utility>
+
+ProgressiveRenderer::ProgressiveRenderer(CpuRenderer &renderer)
+    : mRenderer(renderer)
+    , mThread(&ProgressiveRenderer::workerLoop, this)
+{
+}
+
+ProgressiveRenderer::~ProgressiveRenderer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+        mCancel = true;
+    }
+    mWake.notify_all();
+    mThread.join();
+}
+
+void ProgressiveRenderer::request(const View &view)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mRequest = view;
+        mRequestTime = Clock::now();
+        mHasRequest = true;
+        mHasFinished = false;
+        mCancel = true;
+    }
+    mWake.notify_all();
+}
+
+bool ProgressiveRenderer::takePass(IterationBuffer &iterations, Pass &pass)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mHasFinished) {
+        return false;
+    }
+    std::swap(iterations, mFinished);
+    pass = std::move(mFinishedPass);
+    mHasFinished = false;
+    return true;
+}
+
+void ProgressiveRenderer::workerLoop()
+{
+    for (;;) {
+        View view;
+        Clock::time_point requestTime;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWake.wait(lock, [this]() { return mStop || mHasRequest; });
+            if (mStop) {
+                return;
+            }
+            view = mRequest;
+            requestTime = mRequestTime;
+            mHasRequest = false;
+            // under the lock, so a request arriving from here on cancels this frame
+            mCancel = false;
+        }
+
+        mRenderer.beginFrame(view, mFrame);
+        bool first = true;
+        for (bool more = true; more;) {
+            int step = mRenderer.passStep();
+            more = mRenderer.renderPass(mFrame, &mCancel);
+            if (mCancel) {
+                break;
+            }
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mHasRequest) {
+                break;
+            }
+            mFinished.resize(mFrame.width, mFrame.height);
+            mFinished.data = mFrame.data;
+            mFinishedPass.step = step;
+            // a first pass overtaken before it was taken passes that on
+            mFinishedPass.first = first || (mHasFinished && mFinishedPass.first);
+            mFinishedPass.latency = std::chrono::duration<double>(Clock::now() - requestTime).count();
+            mFinishedPass.stats = more ? CpuRenderer::Stats {} : mRenderer.getStats();
+            mFinishedPass.samples = more ? CpuRenderer::Supersamples {} : mRenderer.getSupersamples();
+            mFinishedPass.distances = more ? std::vector<double> {} : mRenderer.getDistances();
+            mHasFinished = true;
+            first = false;
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "cpurenderer.h"
+
+// Renders CpuRenderer frames pass by pass on a thread of its own, so the window keeps handling events meanwhile.
+// A new view abandons the frame in flight at its next tile, every finished pass is handed over for display.
+class ProgressiveRenderer
+{
+public:
+    struct Pass {
+        // pixel step of the pass, 1 for the finished frame
+        int step = 0;
+        bool first = false;
+        // seconds since the view was requested
+        double latency = 0.0;
+        // with the finished frame
+        CpuRenderer::Stats stats;
+        CpuRenderer::Supersamples samples;
+        std::vector<double> distances;
+    };
+
+    explicit ProgressiveRenderer(CpuRenderer &renderer);
+    ~ProgressiveRenderer();
+    ProgressiveRenderer(const ProgressiveRenderer &) = delete;
+    ProgressiveRenderer &operator=(const ProgressiveRenderer &) = delete;
+
+    // starts rendering view, dropping whatever is left of the previous one
+    void request(const View &view);
+    // Copies the latest finished pass to iterations, false if there was none since the last call. Passes that were
+    // overtaken by a later one before being taken are skipped.
+    bool takePass(IterationBuffer &iterations, Pass &pass);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void workerLoop();
+
+    CpuRenderer &mRenderer;
+    std::mutex mMutex;
+    std::condition_variable mWake;
+    std::atomic<bool> mCancel { false };
+    bool mStop = false;
+    bool mHasRequest = false;
+    View mRequest;
+    Clock::time_point mRequestTime;
+    // written by the worker only
+    IterationBuffer mFrame;
+    // the last finished pass, guarded by mMutex
+    IterationBuffer mFinished;
+    Pass mFinishedPass;
+    bool mHasFinished = false;
+    std::thread mThread;
+};
@@ -0,0 +1,299 @@
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+// Headless batch renderer: one view on the CPU backend to one image file, without a window or a display server.
+//   mandelbrot-render --output FILE [--center RE IM] [--size WIDTH] [--resolution WxH] [--iterations N]
+//                     [--palette NAME] [--reversed] [--julia RE IM] [--threads N] [--stats]
+//                     [--zoom-to SIZE [--frames-per-octave N] [--exponential-map [--strip-width N]]] [CPU renderer flags]
+// The center takes any number of decimals, FILE "-" writes to stdout. It links neither SFML nor the viewer, and leaves
+// out what a single frame doesn't need: progressive passes and the tile cache (a --tile-store still pays off across
+// the renders of a batch).
+// With --zoom-to it renders a zoom movie (see ZoomSequence) from --size down to SIZE, FILE is then a printf pattern
+// with the frame number such as frame%05d.ppm, or "-" for all frames in a row (ffmpeg -f image2pipe -i -).
+// --exponential-map resamples the frames from a log-polar strip of the path (see ExponentialMap).
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "cmdline.h"
+#include "colormap/palettes.hpp"
+#include "colormap/pixmap.hpp"
+#include "cpurenderer.h"
+#include "zoomsequence.h"
+
+using Color = colormap::color<colormap::space::rgb>;
+
+static int usage(const char *error)
+{
+    fprintf(stderr, "%s\n", error);
+    fprintf(stderr, "usage: mandelbrot-render --output FILE [--center RE IM] [--size WIDTH] [--resolution WxH] [--iterations N] [--palette NAME] "
+                    "[--reversed] [--julia RE IM] [--threads N] [--stats] [--no-subdivide] [--no-symmetry] [--snap-axis] [--no-cardioid] [--no-periodicity] "
+                    "[--derivative] [--guess] [--tile-store FILE] [--aa N] [--distance] [--verify] [--zoom-to SIZE [--frames-per-octave N] [--exponential-map [--strip-width N]]]\n");
+    return 2;
+}
+
+// exactly one conversion, a decimal integer with optional flags and width
+static bool isFramePattern(const std::string &pattern)
+{
+    int conversions = 0;
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        if (pattern[i] != '%') {
+            continue;
+        }
+        if (i + 1 < pattern.size() && pattern[i + 1] == '%') {
+            ++i;
+            continue;
+        }
+        i = pattern.find_first_not_of("0123456789-+ ", i + 1);
+        if (i == std::string::npos || pattern[i] != 'd') {
+            return false;
+        }
+        ++conversions;
+    }
+    return conversions == 1;
+}
+
+// Colors a finished frame the way the viewer does and writes it as a binary PPM, false on errors. colors is the
+// palette for every iteration count up to maxIterations, distances and samples those of the frame (may be empty).
+static bool writeImage(const View &view, const IterationBuffer &iterations, const std::vector<double> &distances, const CpuRenderer::Supersamples &samples,
+    const std::vector<Color> &colors, const std::string &output)
+{
+    std::vector<Color> pixels(static_cast<size_t>(view.width) * view.height);
+    for (int y = 0; y < view.height; ++y) {
+        const int *row = iterations.row(y);
+        for (int x = 0; x < view.width; ++x) {
+            pixels[static_cast<size_t>(y) * view.width + x] = colors[row[x]];
+        }
+    }
+    // exterior pixels closer to the set than a pixel get its color
+    if (distances.size() == pixels.size()) {
+        for (size_t i = 0; i < distances.size(); ++i) {
+            if (distances[i] > 0.0 && distances[i] < view.pixelSpacing()) {
+                pixels[i] = colors[view.maxIterations];
+            }
+        }
+    }
+    // an anti-aliased pixel is the mean color of all its samples
+    for (size_t k = 0; k < samples.pixel.size(); ++k) {
+        Color &target = pixels[samples.pixel[k]];
+        unsigned sum[3] = { target.getRed().getValue(), target.getGreen().getValue(), target.getBlue().getValue() };
+        for (int i = samples.first[k]; i < samples.first[k + 1]; ++i) {
+            const Color &color = colors[samples.counts[i]];
+            sum[0] += color.getRed().getValue();
+            sum[1] += color.getGreen().getValue();
+            sum[2] += color.getBlue().getValue();
+        }
+        const unsigned n = samples.first[k + 1] - samples.first[k] + 1;
+        target = Color(static_cast<std::uint8_t>((sum[0] + n / 2) / n), static_cast<std::uint8_t>((sum[1] + n / 2) / n),
+            static_cast<std::uint8_t>((sum[2] + n / 2) / n));
+    }
+
+    colormap::pixmap<std::vector<Color>::const_iterator> image(pixels.cbegin(), std::make_pair<size_t, size_t>(view.width, view.height));
+    if (output == "-") {
+        image.write_binary(std::cout).flush();
+        return static_cast<bool>(std::cout);
+    }
+    std::ofstream file(output, std::ios_base::binary);
+    image.write_binary(file).flush();
+    if (!file) {
+        fprintf(stderr, "Error writing %s\n", output.c_str());
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    View view;
+    view.width = 1000;
+    view.height = 1000;
+    const char *centerRe = "-0.6";
+    const char *centerIm = "0";
+    double size = 3.0;
+    std::string palette = "jet";
+    bool reversed = false;
+    std::string output;
+    unsigned threads = 0;
+    bool printStats = false;
+    double zoomTo = 0.0;
+    int framesPerOctave = 30;
+    bool exponentialMap = false;
+    int stripWidth = 0;
+    CpuRenderer::Options options;
+    // a single frame: nothing to show before it is finished and nothing to pan to afterwards
+    options.passStep = 1;
+    options.tileCacheBytes = 0;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--output" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg == "--center" && i + 2 < argc) {
+            centerRe = argv[++i];
+            centerIm = argv[++i];
+        } else if (arg == "--size" && i + 1 < argc) {
+            size = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--resolution" && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &view.width, &view.height) != 2) {
+                return usage("--resolution takes WIDTHxHEIGHT");
+            }
+        } else if (arg == "--iterations" && i + 1 < argc) {
+            view.maxIterations = std::atoi(argv[++i]);
+        } else if (arg == "--palette" && i + 1 < argc) {
+            palette = argv[++i];
+        } else if (arg == "--reversed") {
+            reversed = true;
+        } else if (arg == "--julia" && i + 2 < argc) {
+            view.type = ShaderType::Julia;
+            const double re = std::strtod(argv[++i], nullptr);
+            view.juliaConst = { re, std::strtod(argv[++i], nullptr) };
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (arg == "--stats") {
+            printStats = true;
+        } else if (arg == "--zoom-to" && i + 1 < argc) {
+            zoomTo = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--frames-per-octave" && i + 1 < argc) {
+            framesPerOctave = std::atoi(argv[++i]);
+        } else if (arg == "--exponential-map") {
+            exponentialMap = true;
+        } else if (arg == "--strip-width" && i + 1 < argc) {
+            stripWidth = std::atoi(argv[++i]);
+        } else if (!parseCpuOption(argc, argv, i, options)) {
+            return usage(("unknown option " + arg).c_str());
+        }
+    }
+    if (output.empty()) {
+        return usage("--output is required");
+    }
+    if (view.width <= 0 || view.height <= 0 || view.maxIterations < 1 || !(size > 0.0)) {
+        return usage("resolution, iterations and size have to be positive");
+    }
+    const bool zoom = zoomTo != 0.0;
+    if (zoom && (!(zoomTo > 0.0 && zoomTo < size) || framesPerOctave < 1)) {
+        return usage("--zoom-to takes a size below --size, --frames-per-octave a positive count");
+    }
+    if (zoom && output != "-" && !isFramePattern(output)) {
+        return usage("--output of a zoom takes a pattern with one %d for the frame number");
+    }
+    if (!colormap::palettes.contains(palette)) {
+        fprintf(stderr, "unknown palette %s, available:", palette.c_str());
+        for (const auto &p : colormap::palettes) {
+            fprintf(stderr, " %.*s", static_cast<int>(p.name.size()), p.name.data());
+        }
+        fprintf(stderr, "\n");
+        return 2;
+    }
+
+    // square pixels, the center with enough fraction limbs for the pixel spacing (as in the viewer)
+    view.planeWidth = size;
+    view.planeHeight = size * view.height / view.width;
+    const int limbs = FixedPoint::getFractionLimbs((zoom ? zoomTo : size) / view.width);
+    if (!FixedPoint::parse(centerRe, limbs, view.centerRe) || !FixedPoint::parse(centerIm, limbs, view.centerIm)) {
+        return usage("--center takes two decimal numbers");
+    }
+
+    CpuRenderer renderer(threads);
+    renderer.setOptions(options);
+    if (!options.tileStore.empty() && !renderer.hasTileStore()) {
+        fprintf(stderr, "Error opening tile store %s: %s\n", options.tileStore.c_str(), strerror(errno));
+    }
+    // the viewer's coloring: the iteration count relative to maxIterations through the palette (exactly, not through
+    // its lookup table, which has fewer entries than there may be counts)
+    const auto &colorMap = colormap::palettes.at(palette);
+    std::vector<Color> colors(view.maxIterations + 1);
+    for (int i = 0; i <= view.maxIterations; ++i) {
+        const double ratio = static_cast<double>(i) / view.maxIterations;
+        colors[i] = colorMap(reversed ? 1 - ratio : ratio);
+    }
+
+    if (zoom) {
+        ZoomSequence::Path path;
+        path.centerRe = view.centerRe;
+        path.centerIm = view.centerIm;
+        path.startSize = size;
+        path.endSize = zoomTo;
+        path.framesPerOctave = framesPerOctave;
+        path.width = view.width;
+        path.height = view.height;
+        path.maxIterations = view.maxIterations;
+        path.type = view.type;
+        path.juliaConst = view.juliaConst;
+        path.exponentialMap = exponentialMap;
+        path.stripWidth = stripWidth;
+        ZoomSequence sequence(renderer, path);
+        CpuRenderer::Stats total;
+        const auto begin = std::chrono::steady_clock::now();
+        for (auto frameBegin = begin; sequence.renderNext(); frameBegin = std::chrono::steady_clock::now()) {
+            const int frame = sequence.currentFrame();
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - frameBegin;
+            const auto &stats = sequence.getStats();
+            total += stats;
+            std::string name = output;
+            if (output != "-") {
+                name.resize(output.size() + 32);
+                name.resize(snprintf(&name[0], name.size(), output.c_str(), frame));
+            }
+            if (!writeImage(sequence.getView(frame), sequence.current(), sequence.getDistances(), sequence.getSupersamples(), colors, name)) {
+                return 1;
+            }
+            if (printStats) {
+                fprintf(stderr, "frame %d/%d: %.1f ms, %lld computed, %lld cached\n", frame + 1, sequence.frames(), elapsed.count() * 1e3, stats.computedPixels,
+                    stats.cachedPixels);
+            }
+        }
+        if (printStats) {
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+            fprintf(stderr, "%d frames of %dx%d, %d iterations in %.1f s (%u threads, %s kernel). Pixels: %lld computed, %lld filled, %lld cached\n",
+                sequence.frames(), view.width, view.height, view.maxIterations, elapsed.count(), renderer.threads(), getKernelIsaName(renderer.isa()),
+                total.computedPixels, total.filledPixels, total.cachedPixels);
+        }
+        if (options.verify) {
+            fprintf(stderr, "Verify: %lld of %lld pixels differ from brute force\n", total.mismatchedPixels,
+                static_cast<long long>(sequence.frames()) * view.width * view.height);
+            return total.mismatchedPixels > 0 ? 1 : 0;
+        }
+        return 0;
+    }
+
+    IterationBuffer iterations;
+    const auto begin = std::chrono::steady_clock::now();
+    renderer.render(view, iterations);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+    if (!writeImage(view, iterations, renderer.getDistances(), renderer.getSupersamples(), colors, output)) {
+        return 1;
+    }
+    if (printStats) {
+        const auto &stats = renderer.getStats();
+        fprintf(stderr, "%dx%d, %d iterations in %.1f ms (%u threads, %s kernel). Pixels: %lld computed, %lld filled, %lld mirrored, %lld cached\n", view.width,
+            view.height, view.maxIterations, elapsed.count() * 1e3, renderer.threads(), getKernelIsaName(renderer.isa()), stats.computedPixels,
+            stats.filledPixels, stats.mirroredPixels, stats.cachedPixels);
+    }
+    if (options.verify) {
+        const auto &stats = renderer.getStats();
+        fprintf(stderr, "Verify: %lld of %lld pixels differ from brute force\n", stats.mismatchedPixels, static_cast<long long>(view.width) * view.height);
+        return stats.mismatchedPixels > 0 ? 1 : 0;
+    }
+    return 0;
+}
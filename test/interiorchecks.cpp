@@ -0,0 +1,64 @@
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+
+// The interior checks of the double kernels must not change any count at the deepest views they are used for, just
+// above the switch to double-double. Points right outside the cusp at c = 0.25 creep past z = 0.5 in steps of about
+// c - 0.25 for tens of millions of iterations, closer together than a fixed tolerance of 1e-14.
+
+#include <cstdio>
+#include <vector>
+#include "../cpurenderer.h"
+#include "../kernel.h"
+
+int main()
+{
+    const double spacing = CpuRenderer::doubleDoubleSpacing * 1.5;
+    const int maxIterations = 50000000;
+    // around 44 and 22 million iterations to escape
+    const std::vector<double> cRe = { 0.25 + 5e-15, 0.25 + 2e-14 };
+    const std::vector<double> cIm = { 0.0, 0.0 };
+    const std::vector<double> zero(cRe.size(), 0.0);
+    const int count = static_cast<int>(cRe.size());
+    EscapeBatch batch { zero.data(), zero.data(), cRe.data(), cIm.data(), count };
+
+    // every instruction set gives the same counts, the one the renderer uses is enough
+    const KernelIsa isa = detectKernelIsa();
+    EscapeKernel kernel = getEscapeKernel(isa);
+    InteriorChecks off;
+    off.periodicity = false;
+    InteriorStats stats;
+    std::vector<int> expected(count);
+    kernel(batch, maxIterations, off, DistanceEstimate(), expected.data(), stats);
+    int failures = 0;
+    for (bool derivative : { false, true }) {
+        InteriorChecks checks;
+        checks.derivative = derivative;
+        checks.scaleTo(spacing);
+        std::vector<int> iterations(count);
+        kernel(batch, maxIterations, checks, DistanceEstimate(), iterations.data(), stats);
+        for (int i = 0; i < count; ++i) {
+            if (iterations[i] != expected[i]) {
+                printf("isa %d, derivative %d: c = %.17g%+.17gi escapes after %d iterations, checks give %d\n", static_cast<int>(isa), derivative,
+                    cRe[i], cIm[i], expected[i], iterations[i]);
+                ++failures;
+            }
+        }
+    }
+    printf("%d mismatches\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Every instruction set must give the scalar kernel's iteration counts (and distance estimates) bit for bit, in double
+// and in double-double precision; that is what the renderer's tile cache, mirroring and --verify rely on. The points are near the boundary, where orbits are
+// long and rounding differences would show, and the batches are not a multiple of any vector width so that lanes
+// are refilled and the tail is partial. Instruction sets the machine lacks are skipped.
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "../doubledouble.h"
+#include "../kernel.h"
+
+namespace {
+
+struct Points {
+    std::vector<double> re, im;
+};
+
+// a width x height grid over the window [re0, re0 + size] x [im0, im0 + size]
+Points makeGrid(double re0, double im0, double size, int width, int height)
+{
+    Points points;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            points.re.push_back(re0 + size * x / width);
+            points.im.push_back(im0 + size * y / height);
+        }
+    }
+    return points;
+}
+
+// a width x height grid of the given spacing around the double-double point (re, im)
+Points makeGrid(DoubleDouble re, DoubleDouble im, double spacing, int width, int height, std::vector<double> &reLo, std::vector<double> &imLo)
+{
+    Points points;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const DoubleDouble pointRe = re + (x - width / 2) * spacing;
+            const DoubleDouble pointIm = im + (y - height / 2) * spacing;
+            points.re.push_back(pointRe.hi);
+            points.im.push_back(pointIm.hi);
+            reLo.push_back(pointRe.lo);
+            imLo.push_back(pointIm.lo);
+        }
+    }
+    return points;
+}
+
+} // namespace
+
+static int compareEscapeKernels(const char *name, const Points &points, bool julia, int maxIterations)
+{
+    const int count = static_cast<int>(points.re.size());
+    // the Julia set of a c inside the main cardioid, near its cusp
+    const std::vector<double> juliaRe(count, 0.26), juliaIm(count, 0.0015), zero(count, 0.0);
+    const EscapeBatch batch = julia ? EscapeBatch { points.re.data(), points.im.data(), juliaRe.data(), juliaIm.data(), count }
+                                    : EscapeBatch { zero.data(), zero.data(), points.re.data(), points.im.data(), count };
+    InteriorChecks off;
+    off.periodicity = false;
+    InteriorChecks derivative;
+    derivative.derivative = true;
+    const InteriorChecks checks[] = { off, InteriorChecks(), derivative };
+
+    int failures = 0;
+    for (const auto &check : checks) {
+        for (bool estimate : { false, true }) {
+            std::vector<int> expected(count);
+            std::vector<double> expectedDistance(count);
+            InteriorStats stats;
+            getEscapeKernel(KernelIsa::Scalar)(batch, maxIterations, check, DistanceEstimate { estimate ? expectedDistance.data() : nullptr, julia },
+                expected.data(), stats);
+            for (KernelIsa isa : { KernelIsa::Avx2, KernelIsa::Avx512 }) {
+                if (isa > detectKernelIsa()) {
+                    continue;
+                }
+                std::vector<int> iterations(count);
+                std::vector<double> distance(count);
+                getEscapeKernel(isa)(batch, maxIterations, check, DistanceEstimate { estimate ? distance.data() : nullptr, julia }, iterations.data(), stats);
+                int mismatches = 0;
+                for (int i = 0; i < count; ++i) {
+                    mismatches += iterations[i] != expected[i] || std::memcmp(&distance[i], &expectedDistance[i], sizeof(double)) != 0;
+                }
+                if (mismatches > 0) {
+                    printf("%s, %s, periodicity %d, derivative %d, distance %d: %d of %d points differ from scalar\n", name, getKernelIsaName(isa),
+                        check.periodicity, check.derivative, estimate, mismatches, count);
+                    ++failures;
+                }
+            }
+        }
+    }
+    return failures;
+}
+
+// the double-double kernels from where they take over down to where perturbation does
+static int compareDoubleDoubleKernels(double spacing, bool julia, int maxIterations)
+{
+    // c = i is a Misiurewicz point: the boundary of the Mandelbrot set runs through every window around it, and the
+    // critical point 0 is on its Julia set
+    std::vector<double> reLo, imLo;
+    const Points points = julia ? makeGrid({ 0.0, 0.0 }, { 0.0, 0.0 }, spacing, 16, 17, reLo, imLo)
+                                : makeGrid({ 0.0, 0.0 }, { 1.0, 0.0 }, spacing, 16, 17, reLo, imLo);
+    const int count = static_cast<int>(points.re.size());
+    const std::vector<double> one(count, 1.0), zero(count, 0.0);
+    const DoubleDoubleBatch batch = julia
+        ? DoubleDoubleBatch { points.re.data(), reLo.data(), points.im.data(), imLo.data(), zero.data(), zero.data(), one.data(), zero.data(), count }
+        : DoubleDoubleBatch { zero.data(), zero.data(), zero.data(), zero.data(), points.re.data(), reLo.data(), points.im.data(), imLo.data(),
+              count };
+
+    std::vector<int> expected(count);
+    getDoubleDoubleKernel(KernelIsa::Scalar)(batch, maxIterations, expected.data());
+    int failures = 0;
+    for (KernelIsa isa : { KernelIsa::Avx2, KernelIsa::Avx512 }) {
+        if (isa > detectKernelIsa()) {
+            continue;
+        }
+        std::vector<int> iterations(count);
+        getDoubleDoubleKernel(isa)(batch, maxIterations, iterations.data());
+        int mismatches = 0;
+        for (int i = 0; i < count; ++i) {
+            mismatches += iterations[i] != expected[i];
+        }
+        if (mismatches > 0) {
+            printf("double-double%s, spacing %g, %s: %d of %d points differ from scalar\n", julia ? " julia" : "", spacing, getKernelIsaName(isa),
+                mismatches, count);
+            ++failures;
+        }
+    }
+    return failures;
+}
+
+int main()
+{
+    const KernelIsa best = detectKernelIsa();
+    for (KernelIsa isa : { KernelIsa::Avx2, KernelIsa::Avx512 }) {
+        if (isa > best) {
+            printf("%s not supported, skipped\n", getKernelIsaName(isa));
+        }
+    }
+
+    int failures = 0;
+    // seahorse valley, the cusp of the main cardioid and the Julia set near its own cusp; 61 x 67 points each
+    failures += compareEscapeKernels("seahorse valley", makeGrid(-0.76, 0.08, 0.04, 61, 67), false, 5000);
+    failures += compareEscapeKernels("cusp", makeGrid(0.245, -0.01, 0.02, 61, 67), false, 5000);
+    failures += compareEscapeKernels("julia", makeGrid(-0.1, -0.1, 0.2, 61, 67), true, 5000);
+    for (double spacing : { 1e-13, 1e-16, 1e-20, 1e-24, 1e-27 }) {
+        for (bool julia : { false, true }) {
+            failures += compareDoubleDoubleKernels(spacing, julia, 20000);
+        }
+    }
+    printf("%d failures\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,76 @@
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Mariani-Silver subdivision must give the same image as computing every pixel: views that used to fill rectangles
+// across the set's boundary, checked with the renderer's own brute force comparison, and one in which the distance
+// estimates refuse fills.
+
+#include <cstdio>
+#include "../cpurenderer.h"
+#include "../fixedpoint.h"
+
+static View makeView(const char *centerRe, const char *centerIm, double size, int width, int height, int maxIterations)
+{
+    View view;
+    view.width = width;
+    view.height = height;
+    view.maxIterations = maxIterations;
+    view.planeWidth = size;
+    view.planeHeight = size * height / width;
+    const int limbs = FixedPoint::getFractionLimbs(size / width);
+    FixedPoint::parse(centerRe, limbs, view.centerRe);
+    FixedPoint::parse(centerIm, limbs, view.centerIm);
+    return view;
+}
+
+static CpuRenderer::Stats render(const View &view, CpuRenderer::Options options)
+{
+    options.passStep = 1;
+    options.tileCacheBytes = 0;
+    options.verify = true;
+    CpuRenderer renderer;
+    renderer.setOptions(options);
+    IterationBuffer iterations;
+    renderer.render(view, iterations);
+    return renderer.getStats();
+}
+
+int main()
+{
+    int failures = 0;
+    // escaping channels between the pixels of interior borders, 13 pixels were filled as interior
+    const View channels = makeView("-0.745", "0.1", 0.01, 400, 300, 2000);
+    for (bool distance : { false, true }) {
+        CpuRenderer::Options options;
+        options.distance = distance;
+        const auto stats = render(channels, options);
+        printf("channels, distance %d: %lld filled, %lld differ from brute force\n", distance, stats.filledPixels, stats.mismatchedPixels);
+        failures += stats.mismatchedPixels > 0;
+    }
+
+    // exterior rectangles around the whole set, the border of some of them comes closer than four pixels to it, so the
+    // distance estimates leave them to be computed
+    const View whole = makeView("-0.75", "0", 3.0, 100, 75, 100);
+    CpuRenderer::Options options;
+    const auto plain = render(whole, options);
+    options.distance = true;
+    const auto guarded = render(whole, options);
+    printf("whole set: %lld filled, %lld with distance estimates (%lld differ from brute force)\n", plain.filledPixels, guarded.filledPixels,
+        guarded.mismatchedPixels);
+    failures += guarded.filledPixels >= plain.filledPixels || guarded.mismatchedPixels > 0;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "threadpool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threads)
+    : mSize(threads ? threads : std::max(1u, std::thread::hardware_concurrency()))
+{
+    for (unsigned i = 0; i < mSize; ++i) {
+        mQueues.push_back(std::make_unique<Queue>());
+    }
+    for (unsigned i = 1; i < mSize; ++i) {
+        mThreads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mStart.notify_all();
+    for (auto &t : mThreads) {
+        t.join();
+    }
+}
+
+void ThreadPool::run(size_t count, const Task &task)
+{
+    if (count == 0) {
+        return;
+    }
+    mTask = &task;
+    mRemaining = count;
+
+    // contiguous chunks keep neighbouring tasks (tiles) on the same worker until someone runs dry and steals
+    for (unsigned w = 0; w < mSize; ++w) {
+        size_t begin = count * w / mSize;
+        size_t end = count * (w + 1) / mSize;
+        std::lock_guard<std::mutex> lock(mQueues[w]->mutex);
+        for (size_t i = begin; i < end; ++i) {
+            mQueues[w]->tasks.push_back(i);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        ++mGeneration;
+    }
+    mStart.notify_all();
+
+    drain(0);
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDone.wait(lock, [this]() { return mRemaining == 0; });
+}
+
+void ThreadPool::workerLoop(unsigned worker)
+{
+    unsigned seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mStart.wait(lock, [&]() { return mStop || mGeneration != seen; });
+            if (mStop) {
+                return;
+            }
+            seen = mGeneration;
+        }
+        drain(worker);
+    }
+}
+
+void ThreadPool::drain(unsigned worker)
+{
+    size_t index;
+    while (pop(worker, index) || steal(worker, index)) {
+        (*mTask)(index, worker);
+        if (--mRemaining == 0) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mDone.notify_all();
+        }
+    }
+}
+
+bool ThreadPool::pop(unsigned worker, size_t &index)
+{
+    auto &queue = *mQueues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    index = queue.tasks.back();
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(unsigned worker, size_t &index)
+{
+    for (unsigned i = 1; i < mSize; ++i) {
+        auto &queue = *mQueues[(worker + i) % mSize];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            index = queue.tasks.front();
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool: every worker owns a deque of task indices, works from its back and, once empty,
+// steals from the front of the others. Meant to be created once and reused for every frame.
+class ThreadPool
+{
+public:
+    using Task = std::function<void(size_t index, unsigned worker)>;
+
+    // threads == 0 uses every available core, the thread calling run() counts as one of them
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Calls task(index, worker) for every index in [0, count) and blocks until all of them are done.
+    // worker is in [0, size()) and unique among the concurrently running tasks (usable to index scratch memory).
+    void run(size_t count, const Task &task);
+    unsigned size() const { return mSize; }
+
+private:
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    void workerLoop(unsigned worker);
+    void drain(unsigned worker);
+    bool pop(unsigned worker, size_t &index);
+    bool steal(unsigned worker, size_t &index);
+
+    unsigned mSize;
+    std::vector<std::unique_ptr<Queue>> mQueues;
+    std::vector<std::thread> mThreads;
+    std::mutex mMutex;
+    std::condition_variable mStart;
+    std::condition_variable mDone;
+    const Task *mTask = nullptr;
+    unsigned mGeneration = 0;
+    std::atomic<size_t> mRemaining { 0 };
+    bool mStop = false;
+};
@@ -0,0 +1,86 @@
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "tilecache.h"
+#include <functional>
+
+size_t TileCache::Hash::operator()(const Key &key) const
+{
+    size_t h = 0;
+    auto combine = [&h](size_t v) { h ^= v + 0x9e3779b97f4a7c15 + (h << 6) + (h >> 2); };
+    combine(std::hash<double>()(key.spacingRe));
+    combine(std::hash<double>()(key.spacingIm));
+    combine(std::hash<long long>()(key.tx));
+    combine(std::hash<long long>()(key.ty));
+    combine(std::hash<int>()(key.maxIterations));
+    combine(static_cast<size_t>(key.type));
+    combine(std::hash<double>()(key.juliaConst.real()));
+    combine(std::hash<double>()(key.juliaConst.imag()));
+    return h;
+}
+
+TileCache::TileCache(int size, size_t budget)
+    : mSize(size)
+    , mBudget(budget)
+{
+}
+
+const int *TileCache::find(const Key &key)
+{
+    auto it = mIndex.find(key);
+    if (it == mIndex.end()) {
+        return nullptr;
+    }
+    mEntries.splice(mEntries.begin(), mEntries, it->second);
+    return it->second->second.data();
+}
+
+void TileCache::insert(const Key &key, std::vector<int> &&tile)
+{
+    if (tileBytes() > mBudget) {
+        return;
+    }
+    auto it = mIndex.find(key);
+    if (it != mIndex.end()) {
+        it->second->second = std::move(tile);
+        mEntries.splice(mEntries.begin(), mEntries, it->second);
+        return;
+    }
+    mEntries.emplace_front(key, std::move(tile));
+    mIndex.emplace(key, mEntries.begin());
+    evict();
+}
+
+void TileCache::setBudget(size_t budget)
+{
+    mBudget = budget;
+    evict();
+}
+
+void TileCache::clear()
+{
+    mEntries.clear();
+    mIndex.clear();
+}
+
+void TileCache::evict()
+{
+    while (!mEntries.empty() && bytes() > mBudget) {
+        mIndex.erase(mEntries.back().first);
+        mEntries.pop_back();
+    }
+}
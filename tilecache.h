@@ -0,0 +1,74 @@
+#pragma once
+
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <complex>
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include "view.h"
+
+// Iteration counts of square tiles of the sampling lattice, least recently used ones are dropped beyond a byte
+// budget. The lattice of a zoom level has pixel (i, j) at (i * spacingRe, -j * spacingIm), tile (tx, ty) holds
+// pixels [tx * size, (tx + 1) * size) x [ty * size, (ty + 1) * size), so panning finds the tiles it saw before.
+class TileCache
+{
+public:
+    struct Key {
+        // the zoom level
+        double spacingRe;
+        double spacingIm;
+        long long tx;
+        long long ty;
+        int maxIterations;
+        ShaderType type;
+        std::complex<double> juliaConst;
+
+        friend bool operator==(const Key &lhs, const Key &rhs)
+        {
+            return lhs.spacingRe == rhs.spacingRe && lhs.spacingIm == rhs.spacingIm && lhs.tx == rhs.tx && lhs.ty == rhs.ty
+                && lhs.maxIterations == rhs.maxIterations && lhs.type == rhs.type && lhs.juliaConst == rhs.juliaConst;
+        }
+    };
+
+    // size is the tile edge in pixels
+    explicit TileCache(int size, size_t budget = 0);
+
+    // the tile's size * size counts row by row, nullptr if it isn't cached; a hit becomes the most recently used
+    const int *find(const Key &key);
+    void insert(const Key &key, std::vector<int> &&tile);
+    void setBudget(size_t budget);
+    void clear();
+    size_t bytes() const { return mEntries.size() * tileBytes(); }
+
+private:
+    struct Hash {
+        size_t operator()(const Key &key) const;
+    };
+    using Entry = std::pair<Key, std::vector<int>>;
+
+    size_t tileBytes() const { return static_cast<size_t>(mSize) * mSize * sizeof(int) + sizeof(Entry); }
+    void evict();
+
+    int mSize;
+    size_t mBudget;
+    // most recently used first
+    std::list<Entry> mEntries;
+    std::unordered_map<Key, std::list<Entry>::iterator, Hash> mIndex;
+};
@@ -0,0 +1,331 @@
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "tilestore.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t tileSize;
+};
+constexpr char fileMagic[8] = { 'M', 'B', 'T', 'I', 'L', 'E', 'S', '\0' };
+constexpr uint32_t fileVersion = 1;
+
+// every record starts 8 byte aligned, size is that of the payload without padding
+struct RecordHeader {
+    uint32_t type;
+    uint32_t size;
+};
+// payload: uint64_t hash, then the counts
+constexpr uint32_t contentsRecord = 1;
+// payload: DiskKey, then the uint64_t file offset of the counts
+constexpr uint32_t indexRecord = 2;
+
+size_t padded(size_t size)
+{
+    return (size + 7) & ~size_t(7);
+}
+
+// exclusive for its scope; an interrupted wait is retried, any other failure (ENOLCK on some network file systems)
+// leaves it unlocked with errno set
+class FileLock
+{
+public:
+    explicit FileLock(int fd)
+        : mFd(fd)
+    {
+        int result;
+        do {
+            result = flock(mFd, LOCK_EX);
+        } while (result != 0 && errno == EINTR);
+        mLocked = result == 0;
+    }
+    ~FileLock()
+    {
+        if (mLocked) {
+            flock(mFd, LOCK_UN);
+        }
+    }
+    bool locked() const { return mLocked; }
+
+private:
+    int mFd;
+    bool mLocked;
+};
+
+}
+
+size_t TileStore::Hash::operator()(const DiskKey &key) const
+{
+    size_t h = 0;
+    auto combine = [&h](size_t v) { h ^= v + 0x9e3779b97f4a7c15 + (h << 6) + (h >> 2); };
+    combine(std::hash<double>()(key.spacingRe));
+    combine(std::hash<double>()(key.spacingIm));
+    combine(std::hash<int64_t>()(key.tx));
+    combine(std::hash<int64_t>()(key.ty));
+    combine(std::hash<int32_t>()(key.maxIterations));
+    combine(key.variant);
+    return h;
+}
+
+TileStore::TileStore(int size)
+    : mSize(size)
+{
+}
+
+TileStore::~TileStore()
+{
+    close();
+}
+
+bool TileStore::open(const std::string &path)
+{
+    close();
+    mFd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (mFd < 0) {
+        return false;
+    }
+    bool valid;
+    {
+        FileLock lock(mFd);
+        FileHeader header;
+        struct stat st;
+        if (!lock.locked() || fstat(mFd, &st) != 0) {
+            valid = false;
+        } else if (st.st_size == 0) {
+            std::memcpy(header.magic, fileMagic, sizeof(header.magic));
+            header.version = fileVersion;
+            header.tileSize = static_cast<uint32_t>(mSize);
+            valid = pwrite(mFd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+        } else {
+            valid = pread(mFd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) && std::memcmp(header.magic, fileMagic, sizeof(header.magic)) == 0
+                && header.version == fileVersion && header.tileSize == static_cast<uint32_t>(mSize);
+            if (!valid) {
+                errno = EINVAL;
+            }
+        }
+    }
+    if (!valid) {
+        int error = errno;
+        close();
+        errno = error;
+        return false;
+    }
+    mEnd = padded(sizeof(FileHeader));
+    scan();
+    return true;
+}
+
+void TileStore::close()
+{
+    if (mData) {
+        munmap(const_cast<unsigned char *>(mData), mMapped);
+    }
+    if (mFd >= 0) {
+        ::close(mFd);
+    }
+    mFd = -1;
+    mData = nullptr;
+    mMapped = 0;
+    mEnd = 0;
+    mIndex.clear();
+    mContents.clear();
+    mPending.clear();
+}
+
+void TileStore::refresh()
+{
+    if (isOpen()) {
+        scan();
+    }
+}
+
+const int *TileStore::find(const TileCache::Key &key, Variant variant) const
+{
+    auto it = mIndex.find(toDiskKey(key, variant));
+    return it != mIndex.end() ? reinterpret_cast<const int *>(mData + it->second) : nullptr;
+}
+
+void TileStore::insert(const TileCache::Key &key, Variant variant, const int *counts)
+{
+    if (isOpen()) {
+        mPending.emplace_back(toDiskKey(key, variant), std::vector<int>(counts, counts + static_cast<size_t>(mSize) * mSize));
+    }
+}
+
+bool TileStore::flush()
+{
+    if (mPending.empty()) {
+        return true;
+    }
+    FileLock lock(mFd);
+    if (!lock.locked()) {
+        // appends of others could interleave with ours and the deduplication would miss their tiles
+        int error = errno;
+        close();
+        errno = error;
+        return false;
+    }
+    // others may have stored the same tiles meanwhile, and a writer that died may have left half a record
+    scan();
+    if (ftruncate(mFd, static_cast<off_t>(mEnd)) != 0) {
+        mPending.clear();
+        return true;
+    }
+
+    std::vector<unsigned char> records;
+    // contents written by this flush, by hash: offset within records
+    std::unordered_multimap<uint64_t, size_t> written;
+    auto append = [&records](uint32_t type, const void *a, size_t aSize, const void *b, size_t bSize) {
+        const size_t at = records.size();
+        RecordHeader header { type, static_cast<uint32_t>(aSize + bSize) };
+        records.resize(at + padded(sizeof(header) + aSize + bSize));
+        std::memcpy(records.data() + at, &header, sizeof(header));
+        std::memcpy(records.data() + at + sizeof(header), a, aSize);
+        std::memcpy(records.data() + at + sizeof(header) + aSize, b, bSize);
+        return at + sizeof(header) + aSize;
+    };
+    for (const auto &[key, counts] : mPending) {
+        if (mIndex.count(key)) {
+            continue;
+        }
+        const uint64_t hash = hashTile(counts.data());
+        uint64_t offset = 0;
+        auto stored = mContents.equal_range(hash);
+        for (auto it = stored.first; it != stored.second && !offset; ++it) {
+            if (std::memcmp(mData + it->second, counts.data(), tileBytes()) == 0) {
+                offset = it->second;
+            }
+        }
+        auto pending = written.equal_range(hash);
+        for (auto it = pending.first; it != pending.second && !offset; ++it) {
+            if (std::memcmp(records.data() + it->second, counts.data(), tileBytes()) == 0) {
+                offset = mEnd + it->second;
+            }
+        }
+        if (!offset) {
+            const size_t at = append(contentsRecord, &hash, sizeof(hash), counts.data(), tileBytes());
+            written.emplace(hash, at);
+            offset = mEnd + at;
+        }
+        append(indexRecord, &key, sizeof(key), &offset, sizeof(offset));
+    }
+    mPending.clear();
+
+    // a short write leaves an incomplete record that readers stop at and the next flush cuts off
+    if (pwrite(mFd, records.data(), records.size(), static_cast<off_t>(mEnd)) == static_cast<ssize_t>(records.size())) {
+        scan();
+    }
+    return true;
+}
+
+TileStore::DiskKey TileStore::toDiskKey(const TileCache::Key &key, Variant variant)
+{
+    DiskKey disk;
+    std::memset(&disk, 0, sizeof(disk));
+    disk.spacingRe = key.spacingRe;
+    disk.spacingIm = key.spacingIm;
+    disk.tx = key.tx;
+    disk.ty = key.ty;
+    disk.juliaRe = key.juliaConst.real();
+    disk.juliaIm = key.juliaConst.imag();
+    disk.maxIterations = key.maxIterations;
+    disk.type = static_cast<int32_t>(key.type);
+    disk.variant = variant;
+    return disk;
+}
+
+// FNV-1a
+uint64_t TileStore::hashTile(const int *counts) const
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    const auto *bytes = reinterpret_cast<const unsigned char *>(counts);
+    for (size_t i = 0; i < tileBytes(); ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3;
+    }
+    return hash;
+}
+
+bool TileStore::map(size_t size)
+{
+    if (mData) {
+        munmap(const_cast<unsigned char *>(mData), mMapped);
+        mData = nullptr;
+        mMapped = 0;
+    }
+    void *data = mmap(nullptr, size, PROT_READ, MAP_SHARED, mFd, 0);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    mData = static_cast<const unsigned char *>(data);
+    mMapped = size;
+    return true;
+}
+
+void TileStore::scan()
+{
+    struct stat st;
+    if (fstat(mFd, &st) != 0) {
+        return;
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    if (size != mMapped && !map(size)) {
+        mIndex.clear();
+        mContents.clear();
+        mEnd = padded(sizeof(FileHeader));
+        return;
+    }
+    // a file that shrank was rewritten from scratch by someone else
+    if (size < mEnd) {
+        mIndex.clear();
+        mContents.clear();
+        mEnd = padded(sizeof(FileHeader));
+    }
+    while (mEnd + sizeof(RecordHeader) <= size) {
+        RecordHeader header;
+        std::memcpy(&header, mData + mEnd, sizeof(header));
+        const size_t payload = mEnd + sizeof(header);
+        const size_t next = mEnd + padded(sizeof(header) + header.size);
+        if (next > size) {
+            break;
+        }
+        if (header.type == contentsRecord && header.size == sizeof(uint64_t) + tileBytes()) {
+            uint64_t hash;
+            std::memcpy(&hash, mData + payload, sizeof(hash));
+            mContents.emplace(hash, payload + sizeof(hash));
+        } else if (header.type == indexRecord && header.size == sizeof(DiskKey) + sizeof(uint64_t)) {
+            DiskKey key;
+            uint64_t offset;
+            std::memcpy(&key, mData + payload, sizeof(key));
+            std::memcpy(&offset, mData + payload + sizeof(key), sizeof(offset));
+            if (offset + tileBytes() <= payload) {
+                mIndex[key] = offset;
+            }
+        }
+        mEnd = next;
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "tilecache.h"
+
+// Tiles of the sampling lattice (see TileCache) kept in a single file that any number of runs and processes share.
+// The file is an append-only sequence of records, tile contents and index entries pointing at them; identical
+// contents (all interior tiles of a zoom level, for instance) are stored once, found by their hash. Reads go through
+// a shared memory mapping, appends take an exclusive lock on the file. Native byte order, not portable between
+// machines.
+class TileStore
+{
+public:
+    // what else changes the counts of a tile, see CpuRenderer::Options
+    using Variant = uint32_t;
+
+    explicit TileStore(int size);
+    ~TileStore();
+    TileStore(const TileStore &) = delete;
+    TileStore &operator=(const TileStore &) = delete;
+
+    // creates the file if needed, false (with errno set) if it can't be used
+    bool open(const std::string &path);
+    void close();
+    bool isOpen() const { return mFd >= 0; }
+
+    // picks up what other processes appended
+    void refresh();
+    // the tile's size * size counts row by row, nullptr if it isn't stored; valid until the next refresh() or flush()
+    const int *find(const TileCache::Key &key, Variant variant) const;
+    // queues a tile for the next flush()
+    void insert(const TileCache::Key &key, Variant variant, const int *counts);
+    // appends the queued tiles; false (with errno set) if the file can't be locked, the store is closed then
+    bool flush();
+
+private:
+    struct DiskKey {
+        double spacingRe;
+        double spacingIm;
+        int64_t tx;
+        int64_t ty;
+        double juliaRe;
+        double juliaIm;
+        int32_t maxIterations;
+        int32_t type;
+        uint32_t variant;
+        uint32_t reserved;
+
+        // no padding in between, so the bytes are the key
+        friend bool operator==(const DiskKey &lhs, const DiskKey &rhs) { return std::memcmp(&lhs, &rhs, sizeof(DiskKey)) == 0; }
+    };
+    static_assert(sizeof(DiskKey) == 64, "DiskKey has padding");
+    struct Hash {
+        size_t operator()(const DiskKey &key) const;
+    };
+
+    static DiskKey toDiskKey(const TileCache::Key &key, Variant variant);
+    size_t tileBytes() const { return static_cast<size_t>(mSize) * mSize * sizeof(int32_t); }
+    uint64_t hashTile(const int *counts) const;
+    bool map(size_t size);
+    void scan();
+
+    int mSize;
+    int mFd = -1;
+    const unsigned char *mData = nullptr;
+    size_t mMapped = 0;
+    // end of the last complete record
+    size_t mEnd = 0;
+    // data offsets of the tiles, and of the contents by hash
+    std::unordered_map<DiskKey, uint64_t, Hash> mIndex;
+    std::unordered_multimap<uint64_t, uint64_t> mContents;
+    std::vector<std::pair<DiskKey, std::vector<int>>> mPending;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <algorithm>
+#include <complex>
+#include "fixedpoint.h"
+
+enum class ShaderType { Mandelbrot, Julia };
+
+// Everything needed to compute a single frame, independent of the backend that draws it.
+// Coordinates are in the complex plane (imaginary axis pointing up), the same as the shaders use.
+// The center is kept at arbitrary precision for deep zooms, everything relative to it fits a double.
+struct View {
+    int width = 100;
+    int height = 100;
+    FixedPoint centerRe = -0.6;
+    FixedPoint centerIm = 0.0;
+    double planeWidth = 3.0;
+    double planeHeight = 3.0;
+    int maxIterations = 100;
+    ShaderType type = ShaderType::Mandelbrot;
+    std::complex<double> juliaConst { 0.0, 0.0 };
+
+    // x, y are pixel coordinates (row 0 at the top), pixel centers are at +0.5 like gl_FragCoord
+    std::complex<double> pixelOffset(double x, double y) const
+    {
+        return { ((x + 0.5) / width - 0.5) * planeWidth, -((y + 0.5) / height - 0.5) * planeHeight };
+    }
+    std::complex<double> pixelToPlane(double x, double y) const
+    {
+        return std::complex<double>(centerRe.toDouble(), centerIm.toDouble()) + pixelOffset(x, y);
+    }
+    double pixelSpacing() const { return std::max(planeWidth / width, planeHeight / height); }
+
+    friend bool operator==(const View &lhs, const View &rhs)
+    {
+        return lhs.width == rhs.width && lhs.height == rhs.height && lhs.centerRe == rhs.centerRe && lhs.centerIm == rhs.centerIm
+            && lhs.planeWidth == rhs.planeWidth && lhs.planeHeight == rhs.planeHeight && lhs.maxIterations == rhs.maxIterations
+            && lhs.type == rhs.type && lhs.juliaConst == rhs.juliaConst;
+    }
+    friend bool operator!=(const View &lhs, const View &rhs) { return !(lhs == rhs); }
+};
@@ -0,0 +1,111 @@
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "zoomsequence.h"
+#include <cmath>
+#include <utility>
+
+ZoomSequence::ZoomSequence(CpuRenderer &renderer, const Path &path) : mRenderer(renderer), mPath(path)
+{
+    auto options = renderer.options();
+    options.symmetry = false;
+    mFrames = static_cast<int>(std::lround(std::log2(path.startSize / path.endSize) * path.framesPerOctave)) + 1;
+    if (path.exponentialMap) {
+        options.logPolar = true;
+        options.antialias = 0;
+        options.distance = false;
+        renderer.setOptions(options);
+        const View first = getView(0);
+        const int width = path.stripWidth > 0 ? path.stripWidth : ExponentialMap::getWidth(first);
+        mMap = std::make_unique<ExponentialMap>(renderer, first, width, std::abs(std::complex<double>(first.planeWidth, first.planeHeight)) / 2);
+        return;
+    }
+    options.centeredGrid = true;
+    renderer.setOptions(options);
+
+    const size_t frameBytes = static_cast<size_t>(path.width) * path.height * sizeof(int);
+    if (mFrames > path.framesPerOctave && static_cast<size_t>(path.framesPerOctave) * frameBytes <= path.reuseBytes) {
+        mOctave.resize(path.framesPerOctave);
+    }
+}
+
+View ZoomSequence::getView(int frame) const
+{
+    View view;
+    view.width = mPath.width;
+    view.height = mPath.height;
+    view.centerRe = mPath.centerRe;
+    view.centerIm = mPath.centerIm;
+    // whole octaves by ldexp, so frames an octave apart have exactly twice the size
+    const int n = mPath.framesPerOctave;
+    view.planeWidth = std::ldexp(mPath.startSize * std::exp2(-static_cast<double>(frame % n) / n), -(frame / n));
+    view.planeHeight = view.planeWidth * view.height / view.width;
+    view.maxIterations = mPath.maxIterations;
+    view.type = mPath.type;
+    view.juliaConst = mPath.juliaConst;
+    return view;
+}
+
+bool ZoomSequence::renderNext()
+{
+    if (mNext >= mFrames) {
+        return false;
+    }
+    if (mMap) {
+        // from the corners down to the center pixel
+        const View view = getView(mNext);
+        mMap->require(view.pixelSpacing() / 2, std::abs(std::complex<double>(view.planeWidth, view.planeHeight)) / 2);
+        mMap->resample(view, mBuffer);
+        ++mNext;
+        return true;
+    }
+    const IterationBuffer *outer = nullptr;
+    IterationBuffer *slot = nullptr;
+    if (!mOctave.empty()) {
+        slot = &mOctave[mNext % mPath.framesPerOctave];
+        if (mNext >= mPath.framesPerOctave) {
+            outer = slot;
+        }
+    }
+    mRenderer.beginFrame(getView(mNext), mBuffer, outer);
+    while (mRenderer.renderPass(mBuffer)) {
+    }
+    // the frame takes the place of the one an octave out, which it no longer needs
+    if (slot) {
+        std::swap(*slot, mBuffer);
+        mCurrent = slot;
+    }
+    ++mNext;
+    return true;
+}
+
+const CpuRenderer::Stats &ZoomSequence::getStats() const
+{
+    return mMap ? mMap->getStats() : mRenderer.getStats();
+}
+
+const CpuRenderer::Supersamples &ZoomSequence::getSupersamples() const
+{
+    static const CpuRenderer::Supersamples none;
+    return mMap ? none : mRenderer.getSupersamples();
+}
+
+const std::vector<double> &ZoomSequence::getDistances() const
+{
+    static const std::vector<double> none;
+    return mMap ? none : mRenderer.getDistances();
+}
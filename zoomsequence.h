@@ -0,0 +1,86 @@
+#pragma once
+
+// mandelbrot -- interactive mandelbrot set explorer
+// Copyright (C) 2022 sedsedus
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <memory>
+#include <vector>
+#include "cpurenderer.h"
+#include "expmap.h"
+
+// Renders the frames of a zoom movie: an exponential zoom from startSize to endSize into one fixed center, a constant
+// number of frames per octave (halving of the plane size). Everything that carries over between frames does:
+// - the renderer with its thread pool and scratch memory
+// - the reference orbit and BLA table of the perturbation frames: the center has the precision of the last frame from
+//   the start, so one orbit serves the whole path, and the table built for the first of them holds for all
+// - pixels: on the centered grid (see CpuRenderer::Options::centeredGrid) frame k has every other pixel of every other
+//   row in common with frame k - framesPerOctave, so a quarter of each frame after the first octave is copied instead
+//   of computed; the last octave is kept for that as long as it fits reuseBytes
+// With Path::exponentialMap the frames are resampled from an ExponentialMap of the path instead, which computes every
+// depth once: far less work than the frames themselves, at the price of nearest neighbour sampling (and no
+// anti-aliasing or distance estimates).
+class ZoomSequence
+{
+public:
+    struct Path {
+        // with the fraction limbs of the last frame, FixedPoint::getFractionLimbs(endSize / width)
+        FixedPoint centerRe;
+        FixedPoint centerIm;
+        double startSize = 3.0;
+        double endSize = 1e-10;
+        int framesPerOctave = 30;
+        int width = 1000;
+        int height = 1000;
+        int maxIterations = 1000;
+        ShaderType type = ShaderType::Mandelbrot;
+        std::complex<double> juliaConst { 0.0, 0.0 };
+        // memory for the frames of the last octave, beyond it every frame is computed in full
+        size_t reuseBytes = size_t(1) << 30;
+        bool exponentialMap = false;
+        // angles of the exponential map, 0 for as many as the corners of the frames need (ExponentialMap::getWidth)
+        int stripWidth = 0;
+    };
+
+    // switches the renderer to the centered grid or log-polar strips (and off symmetry, which neither has)
+    ZoomSequence(CpuRenderer &renderer, const Path &path);
+    ZoomSequence(const ZoomSequence &) = delete;
+    ZoomSequence &operator=(const ZoomSequence &) = delete;
+
+    int frames() const { return mFrames; }
+    // frame k has the plane size startSize / 2^(k / framesPerOctave)
+    View getView(int frame) const;
+    // Renders the next frame, false after the last one. The counts stay valid until the next call, stats, samples and
+    // distances of the frame are those of the renderer.
+    bool renderNext();
+    int currentFrame() const { return mNext - 1; }
+    const IterationBuffer &current() const { return *mCurrent; }
+    // of the current frame, those of an exponential map are the strip bands it added
+    const CpuRenderer::Stats &getStats() const;
+    const CpuRenderer::Supersamples &getSupersamples() const;
+    const std::vector<double> &getDistances() const;
+
+private:
+    CpuRenderer &mRenderer;
+    Path mPath;
+    int mFrames = 0;
+    int mNext = 0;
+    // frame k in mOctave[k % framesPerOctave], empty when the octave doesn't fit the budget
+    std::vector<IterationBuffer> mOctave;
+    IterationBuffer mBuffer;
+    const IterationBuffer *mCurrent = &mBuffer;
+    std::unique_ptr<ExponentialMap> mMap;
+};